@@ -0,0 +1,287 @@
+/*
+ * bench.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arau
+ */
+
+#include "toys/toys.h"
+#include "toys/text.h"
+#include "toys/flex.h"
+#include "toys/flat.h"
+#include "tester.h"
+#include "load.h"
+#include <stdio.h>
+
+using namespace toys;
+using namespace toys::gen;
+
+// sink for the results, so that the optimizer cannot drop the benchmarked calls
+volatile int sink_;
+
+// pointer event, which is not a click. the on_click handlers don't match it,
+// so recv traverses the whole tree
+class touch : public pointevent {
+	public:
+		touch(const vec& xy) : pointevent(xy) {}
+};
+
+// memory policy for the virtual trees: every toy is allocated separately in
+// heap and referred through the abstract itoy interface
+template <typename _traits>
+struct itoy_ref {
+	template <typename T>
+	static std::shared_ptr<itoy<_traits>> ref(T&& t) {
+		return std::make_shared<typename std::decay<T>::type>(std::forward<T>(t));
+	}
+};
+
+class text_canvas {
+	private:
+		vec sz_;
+		std::vector<char> buf_;
+		text_graphics g_;
+	public:
+		text_canvas(const vec& sz)
+		: sz_(sz.x(), sz.y(), 1), buf_(sz_.volume(), ' '), g_(sz_, buf_.data()) {}
+		vec sz() const {
+			return sz_;
+		}
+		text_graphics& g() {
+			return g_;
+		}
+};
+
+template <typename _toy>
+void bench_toy(test_tool& t, const std::set<std::string>& tags, _toy& toy) {
+	text_canvas c(vec(80, 40));
+	vec sz = c.sz();
+	t.bench(tags + "op:size", [&]() {
+		sink_ = toy->size(sz).x();
+	});
+	t.bench(tags + "op:draw", [&]() {
+		toy->draw(sz, c.g());
+	});
+	t.bench(tags + "op:recv", [&]() {
+		touch e(vec(sz.x() / 2, sz.y() / 2));
+		sink_ = toy->recv(sz, e);
+	});
+	perf_counters counters;
+	counters.start();
+	for (int i = 0; i < 1000; ++i) toy->draw(sz, c.g());
+	counters.stop();
+	counters.record(t, tags + "op:draw", 1000);
+}
+
+template <int _depth, typename _wrap, typename _toy>
+auto nest(const _wrap& w, _toy&& toy, std::integral_constant<int, _depth>) {
+	return nest(w, w(std::forward<_toy>(toy)), std::integral_constant<int, _depth-1>());
+}
+template <typename _wrap, typename _toy>
+auto nest(const _wrap& , _toy&& toy, std::integral_constant<int, 0>) {
+	return std::forward<_toy>(toy);
+}
+
+// chain of _depth combinators on top of a rectangle
+template <typename _traits, typename _mem, int _depth, typename _wrap>
+void bench_depth(test_tool& t, const std::string& toy, const std::string& tree, const _wrap& w) {
+	typedef box<_traits, _mem> x;
+	auto z = nest(w, x::rc('x'), std::integral_constant<int, _depth>());
+	bench_toy(t, {"toy:" + toy, "tree:" + tree, sup()<<"depth:"<<_depth}, z);
+}
+
+template <typename _traits, typename _mem, int _depth>
+void bench_depths(test_tool& t, const std::string& tree) {
+	typedef box<_traits, _mem> x;
+	bench_depth<_traits, _mem, _depth>(t, "at", tree, [](auto&& c) {
+		return x::at(vec(1, 0), std::forward<decltype(c)>(c));
+	});
+	bench_depth<_traits, _mem, _depth>(t, "sz", tree, [](auto&& c) {
+		return x::sz(xy(.9, .9), std::forward<decltype(c)>(c));
+	});
+	bench_depth<_traits, _mem, _depth>(t, "lay", tree, [](auto&& c) {
+		return x::lay(mid, std::forward<decltype(c)>(c));
+	});
+	bench_depth<_traits, _mem, _depth>(t, "on", tree, [](auto&& c) {
+		return x::on_click([](click&) { sink_ = 1; }, std::forward<decltype(c)>(c));
+	});
+	// every split level doubles the amount of leaves
+	bench_depth<_traits, _mem, _depth>(t, "split", tree, [](auto&& c) {
+		return x::lr(.5, c, c);
+	});
+}
+
+// row of _width rectangles or texts
+template <typename _traits, typename _mem, size_t... _i>
+void bench_width(test_tool& t, const std::string& tree, std::index_sequence<_i...>) {
+	typedef box<_traits, _mem> x;
+	auto r = x::row(((void)_i, x::rc('x'))...);
+	bench_toy(t, {"toy:rect", "tree:" + tree, sup()<<"width:"<<sizeof...(_i)}, r);
+	auto s = x::row(((void)_i, x::tx(std::string("text"), nothing(), nothing()))...);
+	bench_toy(t, {"toy:text", "tree:" + tree, sup()<<"width:"<<sizeof...(_i)}, s);
+}
+
+template <typename _traits, typename _mem>
+void bench_tree(test_tool& t, const std::string& tree) {
+	bench_depths<_traits, _mem, 1>(t, tree);
+	bench_depths<_traits, _mem, 2>(t, tree);
+	bench_depths<_traits, _mem, 4>(t, tree);
+	bench_depths<_traits, _mem, 8>(t, tree);
+	bench_width<_traits, _mem>(t, tree, std::make_index_sequence<1>());
+	bench_width<_traits, _mem>(t, tree, std::make_index_sequence<4>());
+	bench_width<_traits, _mem>(t, tree, std::make_index_sequence<16>());
+	bench_width<_traits, _mem>(t, tree, std::make_index_sequence<64>());
+}
+
+void bench_combinators( test_tool& t ) {
+	bench_tree<baseless_text_traits, value_copy>(t, "value");
+	bench_tree<text_traits, itoy_ref<text_traits>>(t, "virtual");
+	for (std::string op : {"op:size", "op:draw", "op:recv"}) {
+		for (std::string tree : {"tree:value", "tree:virtual"}) {
+			t<<"\nmedian ns per "<<op<<" of "<<tree<<" trees:\n\n";
+			t.reported()<<t.report(to_table<average>({op, tree, "stat:median", "run:out"}, "toy:", "depth:"));
+			t<<"\n";
+			t.reported()<<t.report(to_table<average>({op, tree, "stat:median", "run:out"}, "toy:", "width:"));
+		}
+	}
+	t.check_regressions();
+	// the hardware counters depend on the machine, so they are shown, but
+	// kept out of the expectations
+	bool counters = perf_counters().available();
+	t<<"\n";
+	t.reported()<<"hardware counters are "<<(counters ? "" : "not ")<<"available";
+	if (counters) {
+		for (std::string counter : {"counter:instructions", "counter:cache-misses"}) {
+			t.noted()<<"\n"<<counter<<" per op:draw of tree:value trees:\n\n"
+					 <<t.report(to_table<average>({"op:draw", "tree:value", counter, "run:out"}, "toy:", "depth:"));
+		}
+	}
+}
+
+// grid of 4^depth click handlers built of nested splits, which works for both
+// the virtual trees and the flat trees, as their builders take runtime trees
+template <typename _x>
+auto quad(int depth) {
+	if (depth == 0) return _x::on_click([](click&) { sink_ = 1; }, _x::rc('x'));
+	return _x::ud(.5, _x::lr(.5, quad<_x>(depth - 1), quad<_x>(depth - 1)),
+					  _x::lr(.5, quad<_x>(depth - 1), quad<_x>(depth - 1)));
+}
+
+// the same trees as linked virtual toys in heap and as flat node tables
+void bench_flat( test_tool& t ) {
+	for (int depth : {1, 3, 5}) {
+		std::string leaves = sup()<<"leaves:"<<(1 << (2 * depth));
+		auto v = quad<box<text_traits, itoy_ref<text_traits>>>(depth);
+		bench_toy(t, {"tree:virtual", leaves, "run:out"}, v);
+		val<flat::tree<text_traits>> f(quad<flat::tree<text_traits>>(depth));
+		bench_toy(t, {"tree:flat", leaves, "run:out"}, f);
+	}
+	for (std::string op : {"op:size", "op:draw", "op:recv"}) {
+		t<<"median ns per "<<op<<":\n\n";
+		t.reported()<<t.report(to_table<average>({op, "stat:median", "run:out"}, "tree:", "leaves:"));
+		t<<"\n";
+	}
+	bool counters = perf_counters().available();
+	t.reported()<<"hardware counters are "<<(counters ? "" : "not ")<<"available";
+	if (counters) {
+		for (std::string counter : {"counter:instructions", "counter:cache-misses"}) {
+			t.noted()<<"\n"<<counter<<" per op:draw:\n\n"
+					 <<t.report(to_table<average>({"op:draw", counter, "run:out"}, "tree:", "leaves:"));
+		}
+	}
+}
+
+// the example is built in the same directory as the benchmark
+const char* example_path = "./toysexample";
+
+// time to first frame of the example: the process time covers the exec,
+// dynamic linking and SDL setup, while the example measures the time from
+// entering main to the first drawn frame. the dummy video driver lets the
+// example run without a display.
+void bench_startup( test_tool& t ) {
+	std::string cmd = std::string("SDL_VIDEODRIVER=dummy ") + example_path + " --first-frame";
+	int failures = 0;
+	for (int i = 0; i < 10; ++i) {
+		time_sentry time;
+		long us = -1;
+		FILE* p = popen(cmd.c_str(), "r");
+		if (p && fscanf(p, "first frame in %ld us", &us) != 1) us = -1;
+		int rv = p ? pclose(p) : -1;
+		double process_us = time.ns() / 1000.;
+		if (us < 0 || rv != 0) {
+			failures++;
+			continue;
+		}
+		t.record({"op:process", "run:out"}, process_us);
+		t.record({"op:main", "run:out"}, double(us));
+	}
+	t<<"running "<<cmd<<"\n";
+	t.reported()<<failures<<" of 10 runs failed";
+	t<<"\n";
+	t<<"us to the first frame:\n\n";
+	t.reported()<<t.report(to_table<average>({"run:out"}, "op:", "run:"));
+}
+
+// runs the click and touch streams of a distribution through the grid
+template <typename _toy, typename _points>
+void bench_stream(test_tool& t, const std::string& handlers, _toy& grid, size_t& clicks,
+				  const vec& area, const _points& points, const load::load_options& o) {
+	std::set<std::string> tags{handlers, std::string("spread:") + points.name(), "run:out"};
+	clicks = 0;
+	size_t received = load::generate<click>(t, tags + "op:click", grid, area, points, o);
+	t<<"  "<<points.name()<<": "<<received<<" clicks received, "
+	 <<(clicks == o.events_ + o.latency_events_ ? "all" : "not all")<<" handled\n";
+	load::generate<touch>(t, tags + "op:touch", grid, area, points, o);
+}
+
+// n x n grid of on_click handlers, which are laid out by the flex containers
+void bench_grid(test_tool& t, size_t n) {
+	typedef baseless_text_traits traits;
+	typedef box<traits, value_copy> x;
+	size_t clicks = 0;
+	auto handler = [&clicks](click&) { clicks++; };
+	typedef decltype(x::on_click(handler, x::rc('x'))) cell;
+	typedef flex<traits, cell> row;
+	flex<traits, val<row>> column(1);
+	for (size_t i = 0; i < n; ++i) {
+		row r(0);
+		for (size_t j = 0; j < n; ++j) r.add(x::on_click(handler, x::rc('x')), flex_item(1));
+		column.add(val<row>(std::move(r)), flex_item(1));
+	}
+	val<flex<traits, val<row>>> grid(std::move(column));
+	vec area(256, 256);
+	std::string handlers = sup()<<"handlers:"<<n * n;
+	// recv is linear in the handlers, so the large grids get fewer events
+	size_t events = std::min(size_t(100000), 10000000 / (n * n));
+	load::load_options o(events, events / 10);
+	t<<n * n<<" handlers:\n";
+	bench_stream(t, handlers, grid, clicks, area, load::uniform(), o);
+	bench_stream(t, handlers, grid, clicks, area, load::gaussian(), o);
+	bench_stream(t, handlers, grid, clicks, area, load::sweep(o.events_), o);
+}
+
+// synthetic pointer streams over grids of growing amount of click handlers
+void bench_load( test_tool& t ) {
+	for (size_t n : {4, 16, 64}) bench_grid(t, n);
+	for (std::string op : {"op:click", "op:touch"}) {
+		t<<"\n"<<op<<" events per second:\n\n";
+		t.reported()<<t.report(to_table<average>({op, "stat:events/s", "run:out"}, "handlers:", "spread:"));
+		for (std::string stat : {"stat:p50", "stat:p99"}) {
+			t<<"\n"<<op<<" "<<stat<<" latency in ns:\n\n";
+			t.reported()<<t.report(to_table<average>({op, stat, "run:out"}, "handlers:", "spread:"));
+		}
+	}
+}
+
+void add_toy_benchs(test_runner& runner) {
+	runner.add("toys/combinators", std::set<std::string>(), &bench_combinators);
+	runner.add("toys/startup", std::set<std::string>(), &bench_startup);
+	runner.add("toys/load", std::set<std::string>(), &bench_load);
+	runner.add("toys/flat", std::set<std::string>(), &bench_flat);
+}
+
+int main(int argc, char** argv) {
+	test_runner t("toys bench", "bench");
+	add_toy_benchs(t);
+	return t.exec(argc, argv);
+}
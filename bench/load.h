@@ -0,0 +1,127 @@
+/*
+ * load.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arau
+ */
+
+#ifndef TOYS_BENCH_LOAD_H
+#define TOYS_BENCH_LOAD_H
+
+#include "toys/toys.h"
+#include "tester.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace toys {
+	namespace load {
+
+		// the spatial distributions of the generated pointer positions. each
+		// gives the position of the i:th event in the area.
+
+		struct uniform {
+			const char* name() const {
+				return "uniform";
+			}
+			template <typename _rng>
+			vec operator()(_rng& rng, const vec& area, size_t ) const {
+				return vec(std::uniform_int_distribution<int>(0, area.x() - 1)(rng),
+						   std::uniform_int_distribution<int>(0, area.y() - 1)(rng));
+			}
+		};
+
+		// normal distribution around the center, with the deviation given
+		// as a fraction of the area. the positions are clamped into the area.
+		struct gaussian {
+			float sigma_;
+			gaussian(float sigma = .125f) : sigma_(sigma) {}
+			const char* name() const {
+				return "gaussian";
+			}
+			template <typename _rng>
+			vec operator()(_rng& rng, const vec& area, size_t ) const {
+				std::normal_distribution<float> x(area.x() / 2.f, area.x() * sigma_);
+				std::normal_distribution<float> y(area.y() / 2.f, area.y() * sigma_);
+				return vec(std::max(0, std::min(area.x() - 1, int(x(rng)))),
+						   std::max(0, std::min(area.y() - 1, int(y(rng)))));
+			}
+		};
+
+		// goes through the area row by row. the points are strided, so that
+		// the given amount of events covers the whole area
+		struct sweep {
+			size_t events_;
+			sweep(size_t events)
+			: events_(events) {}
+			const char* name() const {
+				return "sweep";
+			}
+			template <typename _rng>
+			vec operator()(_rng& , const vec& area, size_t i) const {
+				size_t cells = size_t(area.x() * area.y());
+				size_t stride = std::max(size_t(1), cells / std::max(size_t(1), events_));
+				size_t c = (i * stride) % cells;
+				return vec(int(c % area.x()), int(c / area.x()));
+			}
+		};
+
+		struct load_options {
+			// events for measuring the throughput
+			size_t events_;
+			// events timed one by one for the latency percentiles
+			size_t latency_events_;
+			unsigned seed_;
+			load_options(size_t events = 100000, size_t latency_events = 10000, unsigned seed = 1)
+			: events_(events), latency_events_(latency_events), seed_(seed) {}
+		};
+
+		// drives a stream of pointer events of type _event to the toy's recv.
+		// the events are first routed back to back for the throughput and
+		// then timed one at a time for the latencies. records stat:events/s and
+		// the latency percentiles in ns as stat:p50, stat:p90, stat:p99 and
+		// stat:max. returns the count of events received in the throughput run.
+		template <typename _event, typename _toy, typename _points>
+		size_t generate(test_tool& t, const std::set<std::string>& tags, _toy& toy,
+						const vec& area, const _points& points,
+						const load_options& o = load_options()) {
+			std::mt19937 rng(o.seed_);
+			size_t n = std::max(o.events_, o.latency_events_);
+			std::vector<vec> at(n);
+			for (size_t i = 0; i < n; ++i) {
+				at[i] = points(rng, area, i);
+			}
+
+			size_t received = 0;
+			time_sentry time;
+			for (size_t i = 0; i < o.events_; ++i) {
+				_event e(at[i]);
+				received += toy->recv(area, e);
+			}
+			double ns = time.ns();
+			t.record(tags + "stat:events/s", o.events_ * 1e9 / std::max(ns, 1.));
+
+			std::vector<double> latency(o.latency_events_);
+			for (size_t i = 0; i < o.latency_events_; ++i) {
+				_event e(at[i]);
+				time_sentry event_time;
+				toy->recv(area, e);
+				latency[i] = event_time.ns();
+			}
+			std::sort(latency.begin(), latency.end());
+			if (!latency.empty()) {
+				auto pct = [&latency](double p) {
+					return latency[std::min(latency.size() - 1, size_t(p * latency.size()))];
+				};
+				t.record(tags + "stat:p50", pct(.5));
+				t.record(tags + "stat:p90", pct(.9));
+				t.record(tags + "stat:p99", pct(.99));
+				t.record(tags + "stat:max", latency.back());
+			}
+			return received;
+		}
+
+	}
+}
+
+#endif
@@ -7,6 +7,8 @@
 
 #include "toys/sdl.h"
 #include <sstream>
+#include <chrono>
+#include <cstring>
 
 using namespace std;
 using namespace toys;
@@ -17,6 +19,9 @@ unique_ptr<itoy> make_radio_button(const font& f, const function<void (bool)>& c
 unique_ptr<itoy> make_resizing_item();
 
 int main(int argc, char** argv) {
+    auto started = std::chrono::steady_clock::now();
+    // --first-frame exits after the first frame and prints the time it took
+    bool first_frame = argc > 1 && !strcmp(argv[1], "--first-frame");
     font f("/usr/share/fonts/truetype/freefont/FreeMono.ttf", 20);
     sdltoys i;
 
@@ -47,10 +52,18 @@ int main(int argc, char** argv) {
                                  lay(mid, sz(xy(0.67, 0.5), quit))))),
                 rc(std::ref(c)));
 
+    window<decltype(z)&> wnd("foo", vec(), {400, 400}, z);
+
+    if (first_frame) {
+        wnd.draw();
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - started).count();
+        printf("first frame in %ld us\n", long(us));
+        return 0;
+    }
+
     printf("quit size is %lu B\n", sizeof(quit));
     printf("toy size is %lu B\n", sizeof(z));
 
-    window<decltype(z)&> wnd("foo", vec(), {400, 400}, z);
-
     return i.run(&wnd);
 }
@@ -0,0 +1,225 @@
+/*
+ * anim.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arau
+ */
+
+#ifndef TOYS_ANIM_H
+#define TOYS_ANIM_H
+
+#include "toys/toys.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace toys {
+	namespace anim {
+
+		// something, that changes every frame until it settles
+		class animation {
+			public:
+				virtual ~animation() {}
+				// advances to the time t in seconds. returns false, when settled.
+				virtual bool step(double t) = 0;
+		};
+
+		inline double steady_seconds() {
+			return std::chrono::duration<double>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+		// time source of the animations. the window ticks the clock once per
+		// frame, as long as some animation is active, and the clock steps the
+		// active animations. a settled animation drops out of the clock, so the
+		// idle clock costs nothing.
+		class frame_clock {
+			private:
+				std::function<double()> time_;
+				std::vector<std::shared_ptr<animation>> active_;
+				size_t ticks_;
+			public:
+				frame_clock(std::function<double()> time = &steady_seconds)
+				: time_(std::move(time)), active_(), ticks_(0) {}
+				frame_clock(const frame_clock&) = delete;
+				frame_clock& operator=(const frame_clock&) = delete;
+				double now() const {
+					return time_();
+				}
+				void start(std::shared_ptr<animation> a) {
+					if (std::find(active_.begin(), active_.end(), a) == active_.end()) {
+						active_.push_back(std::move(a));
+					}
+				}
+				bool active() const {
+					return !active_.empty();
+				}
+				// steps the active animations to the current time
+				void tick() {
+					double t = now();
+					ticks_++;
+					// the steps may start new animations, which get stepped next tick
+					std::vector<std::shared_ptr<animation>> stepped;
+					stepped.swap(active_);
+					for (std::shared_ptr<animation>& a : stepped) {
+						if (a->step(t)) active_.push_back(std::move(a));
+					}
+				}
+				size_t ticks() const {
+					return ticks_;
+				}
+		};
+
+		// easing curves over [0, 1]
+		typedef float (*easing)(float);
+
+		inline float linear(float p) {
+			return p;
+		}
+		inline float ease_out(float p) {
+			return 1 - (1 - p) * (1 - p);
+		}
+		inline float ease_in_out(float p) {
+			return p < .5f ? 2 * p * p : 1 - 2 * (1 - p) * (1 - p);
+		}
+
+		template <typename T>
+		T lerp(const T& a, const T& b, float p) {
+			return T(a + (b - a) * p);
+		}
+
+		// animated value, which moves from its current value to the target in
+		// a fixed time. the copies share the value, so a tween can be given to
+		// the toys by value and animated from the event handlers. reading the
+		// value in a cached layer makes the layer a dependency of the tween.
+		template <typename T>
+		class tween {
+			private:
+				struct state : public animation, public gen::source {
+					frame_clock& clock_;
+					T from_;
+					T to_;
+					T value_;
+					double begin_;
+					double duration_;
+					easing ease_;
+					state(frame_clock& clock, const T& v)
+					: clock_(clock), from_(v), to_(v), value_(v), begin_(), duration_(), ease_(&linear) {}
+					bool step(double t) {
+						float p = duration_ > 0 ? float((t - begin_) / duration_) : 1.f;
+						p = std::max(0.f, std::min(1.f, p));
+						T v = p < 1 ? lerp(from_, to_, ease_(p)) : to_;
+						if (v != value_) {
+							value_ = v;
+							changed();
+						}
+						return p < 1;
+					}
+				};
+				std::shared_ptr<state> s_;
+			public:
+				tween(frame_clock& clock, const T& v = T())
+				: s_(std::make_shared<state>(clock, v)) {}
+				// animates from the current value to v in the given seconds
+				void to(const T& v, double seconds, easing ease = &ease_out) {
+					s_->from_ = s_->value_;
+					s_->to_ = v;
+					s_->begin_ = s_->clock_.now();
+					s_->duration_ = seconds;
+					s_->ease_ = ease;
+					s_->clock_.start(s_);
+				}
+				// jumps to v. an active animation settles on the next tick.
+				void set(const T& v) {
+					s_->to_ = v;
+					s_->duration_ = 0;
+					if (v != s_->value_) {
+						s_->value_ = v;
+						s_->changed();
+					}
+				}
+				T get() const {
+					s_->read();
+					return s_->value_;
+				}
+				operator T() const {
+					return get();
+				}
+				const T& target() const {
+					return s_->to_;
+				}
+		};
+
+		// damped spring, which follows its target with a physical motion. the
+		// motion is integrated in fixed steps, so the result doesn't depend on
+		// the frame rate. the spring settles, when both the distance to the
+		// target and the velocity drop under the precision.
+		class spring {
+			private:
+				struct state : public animation, public gen::source {
+					frame_clock& clock_;
+					float value_;
+					float velocity_;
+					float target_;
+					float stiffness_;
+					float damping_;
+					float precision_;
+					double time_;
+					state(frame_clock& clock, float v, float stiffness, float damping, float precision)
+					: clock_(clock), value_(v), velocity_(), target_(v),
+					  stiffness_(stiffness), damping_(damping), precision_(precision), time_() {}
+					bool step(double t) {
+						static const double dt = 1. / 240;
+						// a long stall would otherwise take arbitrarily many steps
+						if (t - time_ > .25) time_ = t - .25;
+						float v = value_;
+						for (; time_ + dt <= t; time_ += dt) {
+							float a = stiffness_ * (target_ - v) - damping_ * velocity_;
+							velocity_ += float(a * dt);
+							v += float(velocity_ * dt);
+						}
+						bool settled = std::fabs(target_ - v) < precision_
+									&& std::fabs(velocity_) < precision_;
+						if (settled) {
+							v = target_;
+							velocity_ = 0;
+						}
+						if (v != value_) {
+							value_ = v;
+							changed();
+						}
+						return !settled;
+					}
+				};
+				std::shared_ptr<state> s_;
+			public:
+				spring(frame_clock& clock, float v = 0,
+					   float stiffness = 170, float damping = 26, float precision = .01f)
+				: s_(std::make_shared<state>(clock, v, stiffness, damping, precision)) {}
+				// moves towards v, keeping the current velocity
+				void to(float v) {
+					if (s_->target_ == s_->value_ && s_->velocity_ == 0) { // settled
+						s_->time_ = s_->clock_.now();
+					}
+					s_->target_ = v;
+					s_->clock_.start(s_);
+				}
+				float get() const {
+					s_->read();
+					return s_->value_;
+				}
+				operator float() const {
+					return get();
+				}
+				float target() const {
+					return s_->target_;
+				}
+		};
+
+	}
+}
+
+#endif
@@ -0,0 +1,334 @@
+/*
+ * flat.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arau
+ */
+
+#ifndef TOYS_FLAT_H
+#define TOYS_FLAT_H
+
+#include "toys/toys.h"
+#include <functional>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace toys {
+	namespace flat {
+
+		// split or translation value, which is absolute for ints and relative
+		// to the size for doubles like aval and rval
+		struct val {
+			float v_;
+			bool relative_;
+			val(int v) : v_(float(v)), relative_(false) {}
+			val(double v) : v_(float(v)), relative_(true) {}
+			int operator() (int s) const {
+				return relative_ ? int(s * v_) : int(v_);
+			}
+		};
+
+		// translation or size as data. a vec is taken as it is, like in the
+		// gen toys, while the x and y values keep the z of the size like tr.
+		struct tr {
+			val x_;
+			val y_;
+			int z_;
+			bool keep_z_;
+			tr(const vec& v) : x_(v.x()), y_(v.y()), z_(v.z()), keep_z_(false) {}
+			tr(val x, val y) : x_(x), y_(y), z_(0), keep_z_(true) {}
+			vec operator() (const vec& s) const {
+				return vec(x_(s.x()), y_(s.y()), keep_z_ ? s.z() : z_);
+			}
+		};
+
+		const tr mid(.5, .5);
+
+		// toy tree defined in run time and stored as flat tables instead of
+		// linked toys. the nodes are in pre-order, so a unary node's child is
+		// the next node and the second child of a split starts, where the first
+		// child's subtree ends. the parameters of the nodes are in per kind
+		// tables. the nodes have the semantics of the gen toys with the same
+		// names.
+		//
+		// the layout walks the nodes once in index order and stores the
+		// translation and size for each node. the draw goes through the leaves
+		// in the drawing order of the gen toys, where a split draws its second
+		// child before the first. the hit test walks the nodes in index order,
+		// which is the order the gen toys receive the events, and stops at the
+		// first node that takes the event.
+		template <typename _traits>
+		class tree : public _traits::base_type {
+			public:
+				typedef typename _traits::graphics_type graphics_type;
+				typedef typename _traits::pixel_type pixel_type;
+				typedef gen::text<_traits, std::string,
+								  typename _traits::font_type,
+								  typename _traits::color_type> text_type;
+				typedef std::function<void(click&)> handler;
+			private:
+				enum kind : uint8_t { rect_node, at_node, sz_node, lay_node, split_node, on_node, text_node };
+				struct split_param {
+					int dim_;
+					val split_;
+				};
+
+				// nodes
+				std::vector<uint8_t> kind_;
+				std::vector<uint32_t> end_;   // index past the node's subtree
+				std::vector<uint32_t> param_; // index in the table of the node's kind
+
+				// parameters
+				std::vector<pixel_type> pixels_;
+				std::vector<tr> trs_;
+				std::vector<split_param> splits_;
+				std::vector<handler> handlers_;
+				std::vector<text_type> texts_;
+
+				// layout
+				mutable std::vector<vec> pos_;
+				mutable std::vector<vec> size_;
+				mutable std::vector<uint32_t> leaves_; // in drawing order
+				mutable vec laid_for_;
+				mutable bool laid_;
+
+				tree() : kind_(), end_(), param_(), pixels_(), trs_(), splits_(), handlers_(), texts_(),
+						 pos_(), size_(), leaves_(), laid_for_(), laid_(false) {}
+
+				void node(kind k, uint32_t param) {
+					kind_.push_back(k);
+					end_.push_back(uint32_t(kind_.size()));
+					param_.push_back(param);
+				}
+				uint32_t table_size(uint8_t k) const {
+					switch (k) {
+					case rect_node:  return uint32_t(pixels_.size());
+					case split_node: return uint32_t(splits_.size());
+					case on_node:    return uint32_t(handlers_.size());
+					case text_node:  return uint32_t(texts_.size());
+					default:         return uint32_t(trs_.size());
+					}
+				}
+				// appends the child's nodes and parameters as the last subtree
+				// of the root node
+				void append(const tree& c) {
+					uint32_t offset = uint32_t(kind_.size());
+					uint32_t tables[text_node + 1];
+					for (uint8_t k = 0; k <= text_node; ++k) tables[k] = table_size(k);
+					for (size_t i = 0; i < c.kind_.size(); ++i) {
+						kind_.push_back(c.kind_[i]);
+						end_.push_back(c.end_[i] + offset);
+						param_.push_back(c.param_[i] + tables[c.kind_[i]]);
+					}
+					pixels_.insert(pixels_.end(), c.pixels_.begin(), c.pixels_.end());
+					trs_.insert(trs_.end(), c.trs_.begin(), c.trs_.end());
+					splits_.insert(splits_.end(), c.splits_.begin(), c.splits_.end());
+					handlers_.insert(handlers_.end(), c.handlers_.begin(), c.handlers_.end());
+					texts_.insert(texts_.end(), c.texts_.begin(), c.texts_.end());
+					end_[0] = uint32_t(kind_.size());
+					laid_ = false;
+				}
+				static tree unary(kind k, const tr& t, const tree& c) {
+					tree rv;
+					rv.node(k, uint32_t(rv.trs_.size()));
+					rv.trs_.push_back(t);
+					rv.append(c);
+					return rv;
+				}
+
+				// the size of the node i for the given size, like the gen toys'
+				// size(). the chains of unary nodes are followed without recursion.
+				vec measure(uint32_t i, vec s) const {
+					vec add;
+					for (;;) {
+						switch (kind_[i]) {
+						case at_node: {
+							vec a = trs_[param_[i]](s);
+							add += a;
+							s -= a;
+							i++;
+							break;
+						}
+						case on_node:
+							i++;
+							break;
+						case sz_node:
+							return trs_[param_[i]](s) + add;
+						case text_node:
+							return texts_[param_[i]].size(s) + add;
+						default: // rect, lay and split take the size they get
+							return s + add;
+						}
+					}
+				}
+				void layout(const vec& sz) const {
+					if (laid_ && laid_for_ == sz) return;
+					trace_scope<_traits> trace("flat.layout");
+					size_t n = kind_.size();
+					pos_.resize(n);
+					size_.resize(n);
+					pos_[0] = vec();
+					size_[0] = sz;
+					for (uint32_t i = 0; i < n; ++i) {
+						vec p = pos_[i], s = size_[i];
+						switch (kind_[i]) {
+						case at_node: {
+							vec a = trs_[param_[i]](s);
+							pos_[i+1] = p + a;
+							size_[i+1] = s - a;
+							break;
+						}
+						case sz_node:
+							pos_[i+1] = p;
+							size_[i+1] = trs_[param_[i]](s);
+							break;
+						case lay_node:
+							pos_[i+1] = p + trs_[param_[i]](s - measure(i+1, s));
+							size_[i+1] = s;
+							break;
+						case split_node: {
+							const split_param& sp = splits_[param_[i]];
+							uint32_t second = end_[i+1];
+							vec z(s), at;
+							z[sp.dim_] = sp.split_(s[sp.dim_]);
+							pos_[i+1] = p;
+							size_[i+1] = measure(i+1, z);
+							at[sp.dim_] = z[sp.dim_];
+							z[sp.dim_] = s[sp.dim_] - z[sp.dim_];
+							pos_[second] = p + at;
+							size_[second] = measure(second, z);
+							break;
+						}
+						case on_node:
+							pos_[i+1] = p;
+							size_[i+1] = s;
+							break;
+						}
+					}
+					leaves_.clear();
+					std::vector<uint32_t> stack(1, 0);
+					while (!stack.empty()) {
+						uint32_t i = stack.back();
+						stack.pop_back();
+						switch (kind_[i]) {
+						case rect_node:
+						case text_node:
+							leaves_.push_back(i);
+							break;
+						case split_node:
+							stack.push_back(i+1); // the first child gets drawn last
+							stack.push_back(end_[i+1]);
+							break;
+						default:
+							stack.push_back(i+1);
+						}
+					}
+					laid_for_ = sz;
+					laid_ = true;
+				}
+			public:
+				static tree rc(pixel_type p) {
+					tree rv;
+					rv.node(rect_node, 0);
+					rv.pixels_.push_back(std::move(p));
+					return rv;
+				}
+				static tree tx(std::string text,
+							   const typename _traits::font_type& font = typename _traits::font_type(),
+							   typename _traits::color_type color = typename _traits::color_type()) {
+					tree rv;
+					rv.node(text_node, 0);
+					rv.texts_.push_back(text_type(std::move(text), font, std::move(color)));
+					return rv;
+				}
+				static tree at(const tr& t, const tree& c) {
+					return unary(at_node, t, c);
+				}
+				static tree sz(const tr& t, const tree& c) {
+					return unary(sz_node, t, c);
+				}
+				static tree lay(const tr& t, const tree& c) {
+					return unary(lay_node, t, c);
+				}
+				static tree on_click(handler f, const tree& c) {
+					tree rv;
+					rv.node(on_node, 0);
+					rv.handlers_.push_back(std::move(f));
+					rv.append(c);
+					return rv;
+				}
+				static tree split(int dim, val sp, const tree& first, const tree& second) {
+					tree rv;
+					rv.node(split_node, 0);
+					rv.splits_.push_back(split_param{dim, sp});
+					rv.append(first);
+					rv.append(second);
+					return rv;
+				}
+				static tree lr(val sp, const tree& first, const tree& second) {
+					return split(0, sp, first, second);
+				}
+				static tree ud(val sp, const tree& first, const tree& second) {
+					return split(1, sp, first, second);
+				}
+				static tree fb(const tree& front, const tree& back) {
+					return split(2, val(.5), front, back);
+				}
+
+				size_t count() const {
+					return kind_.size();
+				}
+				// the layout gets redone on the next use
+				void invalidate() {
+					laid_ = false;
+				}
+				vec size(const vec& sz) const {
+					trace_scope<_traits> trace("flat.size");
+					return measure(0, sz);
+				}
+				void draw(const vec& sz, graphics_type& g) const {
+					trace_scope<_traits> trace("flat.draw");
+					layout(sz);
+					translation_cursor<graphics_type> c(g);
+					for (uint32_t i : leaves_) {
+						c.move(pos_[i]);
+						if (g.culled(size_[i])) continue;
+						if (kind_[i] == rect_node) {
+							gen::fill_rect<graphics_type, pixel_type>(g, size_[i], pixels_[param_[i]]);
+						} else {
+							texts_[param_[i]].draw(size_[i], g);
+						}
+					}
+				}
+				bool recv(const vec& sz, ievent& e) {
+					trace_scope<_traits> trace("flat.recv");
+					layout(sz);
+					click* ce = dynamic_cast<click*>(&e);
+					translation_cursor<ievent> c(e);
+					for (uint32_t i = 0, n = uint32_t(kind_.size()); i < n; ++i) {
+						if (kind_[i] == rect_node) {
+							c.move(pos_[i]);
+							if (e.hit(size_[i])) return true;
+						} else if (kind_[i] == on_node && ce) {
+							c.move(pos_[i]);
+							if (ce->hit(size_[i])) {
+								handlers_[param_[i]](*ce);
+								return true;
+							}
+						}
+					}
+					return false;
+				}
+				// only the click handlers take events, while the hits depend
+				// on the rectangles in the tree
+				static const unsigned interest_mask = click_bit;
+				unsigned interest() const {
+					return handlers_.empty() ? 0 : click_bit;
+				}
+		};
+
+	}
+}
+
+#endif
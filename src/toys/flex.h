@@ -0,0 +1,224 @@
+/*
+ * flex.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arau
+ */
+
+#ifndef TOYS_FLEX_H
+#define TOYS_FLEX_H
+
+#include "toys/toys.h"
+#include <vector>
+#include <limits>
+#include <cmath>
+#include <algorithm>
+
+namespace toys {
+
+	// how a flex item's main axis length is resolved. the item starts from
+	// its measured content size clamped into [min, max] and then grows or shrinks
+	// in proportion to grow and shrink*length, when there is space left or
+	// missing in the container.
+	struct flex_item {
+		float grow_;
+		float shrink_;
+		int min_;
+		int max_;
+		flex_item(float grow = 0, float shrink = 1,
+				  int min = 0, int max = std::numeric_limits<int>::max())
+		: grow_(grow), shrink_(shrink), min_(min), max_(max) {}
+	};
+
+	namespace gen {
+
+		// container for a list of children defined in run time. the children
+		// are laid one after another in the given dimension with flex style
+		// grow/shrink rules. the measured content sizes and the resulting layout
+		// are cached until the container size changes or a child is invalidated,
+		// so drawing and event handling don't re-measure the children.
+		template <typename _traits, typename _toy_ref = itoy<_traits>*>
+		class flex : public _traits::base_type {
+			public:
+				typedef typename _traits::graphics_type graphics_type;
+			private:
+				struct item {
+					_toy_ref toy_;
+					flex_item flex_;
+					mutable vec measured_;
+					mutable bool valid_;
+					item(_toy_ref toy, const flex_item& f)
+					: toy_(std::move(toy)), flex_(f), measured_(), valid_(false) {}
+				};
+				size_t dim_;
+				std::vector<item> items_;
+				mutable std::vector<int> pos_;
+				mutable std::vector<int> len_;
+				mutable vec laid_for_;
+				mutable bool laid_;
+				mutable size_t measures_;
+
+				static int clamp(const flex_item& f, float v) {
+					return std::max(f.min_, std::min(f.max_, int(std::lround(v))));
+				}
+				void measure(const vec& sz) const {
+					for (const item& i : items_) {
+						if (!i.valid_) {
+							i.measured_ = i.toy_->size(sz);
+							i.valid_ = true;
+							measures_++;
+						}
+					}
+				}
+				// resolves the lengths by distributing the free space and freezing the items,
+				// which hit their min/max limits, until the rest of items can take the space
+				void resolve(int space) const {
+					size_t n = items_.size();
+					std::vector<float> len(n);
+					std::vector<bool> frozen(n);
+					for (size_t i = 0; i < n; ++i) {
+						len[i] = clamp(items_[i].flex_, items_[i].measured_[dim_]);
+					}
+					for (size_t round = 0; round < n + 1; ++round) {
+						float used = 0, weights = 0;
+						for (size_t i = 0; i < n; ++i) used += len[i];
+						float free = space - used;
+						if (std::fabs(free) < 0.5f) break;
+						for (size_t i = 0; i < n; ++i) {
+							if (frozen[i]) continue;
+							const flex_item& f = items_[i].flex_;
+							weights += (free > 0) ? f.grow_ : f.shrink_ * len[i];
+						}
+						if (weights <= 0) break;
+						bool clamped = false;
+						for (size_t i = 0; i < n; ++i) {
+							if (frozen[i]) continue;
+							const flex_item& f = items_[i].flex_;
+							float w = (free > 0) ? f.grow_ : f.shrink_ * len[i];
+							float l = len[i] + free * w / weights;
+							if (l < f.min_ || l > f.max_) {
+								l = std::max(float(f.min_), std::min(float(f.max_), l));
+								frozen[i] = true;
+								clamped = true;
+							}
+							len[i] = l;
+						}
+						if (!clamped) break;
+					}
+					// round the edges rather than lengths to avoid accumulating gaps
+					pos_.resize(n);
+					len_.resize(n);
+					float at = 0;
+					for (size_t i = 0; i < n; ++i) {
+						pos_[i] = int(std::lround(at));
+						at += len[i];
+						len_[i] = int(std::lround(at)) - pos_[i];
+					}
+				}
+				void layout(const vec& sz) const {
+					bool resized = sz[0] != laid_for_[0] || sz[1] != laid_for_[1] || sz[2] != laid_for_[2];
+					if (resized) {
+						for (const item& i : items_) i.valid_ = false;
+					}
+					if (!laid_ || resized) {
+						trace_scope<_traits> trace("flex.layout");
+						measure(sz);
+						resolve(sz[dim_]);
+						laid_for_ = sz;
+						laid_ = true;
+					}
+				}
+				vec item_size(const vec& sz, size_t i) const {
+					vec z(sz);
+					z[dim_] = len_[i];
+					return z;
+				}
+			public:
+				flex(size_t dim)
+				: dim_(dim), items_(), pos_(), len_(), laid_for_(), laid_(false), measures_(0) {}
+				size_t add(_toy_ref toy, const flex_item& f = flex_item()) {
+					items_.push_back(item(std::move(toy), f));
+					laid_ = false;
+					return items_.size() - 1;
+				}
+				void clear() {
+					items_.clear();
+					laid_ = false;
+				}
+				size_t count() const {
+					return items_.size();
+				}
+				_toy_ref& toy(size_t i) {
+					return items_[i].toy_;
+				}
+				// the child i has changed and needs to be measured again
+				void invalidate(size_t i) {
+					items_[i].valid_ = false;
+					laid_ = false;
+				}
+				void invalidate() {
+					for (item& i : items_) i.valid_ = false;
+					laid_ = false;
+				}
+				// the content size, which is the sum of the resolved lengths in the
+				// main axis and the largest measured child in the cross axis
+				vec size(const vec& sz) const {
+					trace_scope<_traits> trace("flex.size");
+					layout(sz);
+					vec rv(sz);
+					rv[dim_] = 0;
+					for (int l : len_) rv[dim_] += l;
+					size_t cross = dim_ ? 0 : 1;
+					rv[cross] = 0;
+					for (const item& i : items_) rv[cross] = std::max(rv[cross], i.measured_[cross]);
+					return rv;
+				}
+				// number of child measurements done so far
+				size_t measures() const {
+					return measures_;
+				}
+				void draw(const vec& sz, graphics_type& g) const {
+					trace_scope<_traits> trace("flex.draw");
+					layout(sz);
+					translation_cursor<graphics_type> c(g);
+					for (size_t i = items_.size(); i-- > 0; ) {
+						vec at;
+						at[dim_] = pos_[i];
+						c.move(at);
+						vec z = item_size(sz, i);
+						if (!g.culled(z)) items_[i].toy_->draw(z, g);
+					}
+				}
+				bool recv(const vec& sz, ievent& e) {
+					trace_scope<_traits> trace("flex.recv");
+					layout(sz);
+					translation_cursor<ievent> c(e);
+					for (size_t i = 0; i < items_.size(); ++i) {
+						vec at;
+						at[dim_] = pos_[i];
+						if (ignores(items_[i].toy_, e)) continue;
+						c.move(at);
+						if (deliver(items_[i].toy_, item_size(sz, i), e)) return true;
+					}
+					return false;
+				}
+				static const unsigned interest_mask = interest_of<_toy_ref>::value;
+				static const takes_hits hits = moved_hits(hits_of<_toy_ref>::value);
+				unsigned interest() const {
+					unsigned rv = 0;
+					for (const item& i : items_) rv |= interest_in(i.toy_);
+					return rv;
+				}
+				takes_hits takes() const {
+					for (const item& i : items_) {
+						if (hits_in(i.toy_) != hits_none) return hits_shape;
+					}
+					return hits_none;
+				}
+		};
+
+	}
+
+}
+
+#endif
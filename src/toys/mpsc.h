@@ -0,0 +1,70 @@
+/*
+ * mpsc.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arau
+ */
+
+#ifndef TOYS_MPSC_H
+#define TOYS_MPSC_H
+
+#include <atomic>
+#include <utility>
+
+namespace toys {
+
+	// unbounded lock-free queue for many producer threads and one consumer
+	// thread. the producers swap their node in as the new head with a single
+	// exchange and then link the previous head to it. the consumer follows the
+	// links from the tail, which is always a drained node, so the producers
+	// and the consumer never touch the same node's value.
+	//
+	// a producer, which is preempted between the exchange and the link, hides
+	// the later nodes from the consumer until it resumes. pop() then reports
+	// the queue as empty, which is fine for the consumer, that gets woken again.
+	template <typename T>
+	class mpsc_queue {
+		private:
+			struct node {
+				std::atomic<node*> next_;
+				T value_;
+				node() : next_(nullptr), value_() {}
+				node(T&& v) : next_(nullptr), value_(std::move(v)) {}
+			};
+			std::atomic<node*> head_;
+			node* tail_;
+		public:
+			mpsc_queue() : head_(new node()), tail_(head_.load(std::memory_order_relaxed)) {}
+			mpsc_queue(const mpsc_queue&) = delete;
+			mpsc_queue& operator=(const mpsc_queue&) = delete;
+			~mpsc_queue() {
+				while (tail_) {
+					node* n = tail_->next_.load(std::memory_order_relaxed);
+					delete tail_;
+					tail_ = n;
+				}
+			}
+			// any thread
+			void push(T v) {
+				node* n = new node(std::move(v));
+				node* prev = head_.exchange(n, std::memory_order_acq_rel);
+				prev->next_.store(n, std::memory_order_release);
+			}
+			// the consumer thread only
+			bool pop(T& v) {
+				node* next = tail_->next_.load(std::memory_order_acquire);
+				if (!next) return false;
+				v = std::move(next->value_);
+				delete tail_;
+				tail_ = next;
+				return true;
+			}
+			// the consumer thread only
+			bool empty() const {
+				return !tail_->next_.load(std::memory_order_acquire);
+			}
+	};
+
+}
+
+#endif
@@ -21,57 +21,308 @@ char* gets(char*);
 
 
 #include "toys/toys.h"
+#include "toys/mpsc.h"
+#include "toys/anim.h"
 #include <stdint.h>
 
 
 #include <string>
+#include <sstream>
+#include <fstream>
+#include <algorithm>
+#include <vector>
+#include <limits>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <functional>
 
 namespace toys {
 	namespace sdl {
 
+		// sets up only the video and events subsystems by default. the other
+		// subsystems are set up on demand and the fonts set up the TTF on
+		// their first use, so that short lived tools don't pay for the parts
+		// of SDL they don't use.
 		class sdltoys {
 		public:
-			sdltoys() {
-				if (SDL_Init(SDL_INIT_EVERYTHING) == -1) {
+			sdltoys(Uint32 subsystems = SDL_INIT_VIDEO | SDL_INIT_EVENTS) {
+				if (SDL_Init(subsystems) == -1) {
 					throw std::runtime_error("setting up SDL failed");
 				}
-				if (TTF_Init() == -1){
+			}
+			static void require(Uint32 subsystems) {
+				Uint32 missing = subsystems & ~SDL_WasInit(subsystems);
+				if (missing && SDL_InitSubSystem(missing) == -1) {
+					throw std::runtime_error("setting up SDL subsystem failed");
+				}
+			}
+			// makes SDL use the dummy video driver, so that windows can be
+			// created and drawn without a display. call before constructing.
+			static void headless() {
+				SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+			}
+			static void require_ttf() {
+				if (!TTF_WasInit() && TTF_Init() == -1) {
 					throw std::runtime_error("setting up TFF failed");
 				}
 			}
 			template <typename _toyr>
 			int run(_toyr r);
-			~sdltoys() {
-				TTF_Quit();
-				SDL_Quit();
+			~sdltoys();
+		};
+
+		// font file at a point size and style, which is opened on the first use
+		class font_face {
+		private:
+			std::string path_;
+			int size_;
+			int style_;
+			std::mutex lock_;
+			std::atomic<TTF_Font*> font_;
+			TTF_Font* open() {
+				std::lock_guard<std::mutex> l(lock_);
+				TTF_Font* f = font_.load();
+				if (!f) {
+					{
+						std::lock_guard<std::mutex> t(ttf_lock());
+						sdltoys::require_ttf();
+						f = TTF_OpenFont(path_.c_str(), size_);
+						if (f) TTF_SetFontStyle(f, style_);
+					}
+					if (!f) {
+						throw std::runtime_error("opening font " + path_ + " failed");
+					}
+					font_.store(f);
+				}
+				return f;
+			}
+		public:
+			// the TTF calls share the freetype library instance and the glyph
+			// caches of the faces, so they all run under this lock. take it only
+			// after getting the font, as opening the face takes it too.
+			static std::mutex& ttf_lock() {
+				static std::mutex l;
+				return l;
+			}
+			font_face(const std::string& path, int size, int style)
+			: path_(path), size_(size), style_(style), lock_(), font_(nullptr) {}
+			font_face(const font_face&) = delete;
+			font_face& operator=(const font_face&) = delete;
+			TTF_Font* get() {
+				TTF_Font* f = font_.load(std::memory_order_acquire);
+				return f ? f : open();
+			}
+			bool loaded() const {
+				return font_.load() != nullptr;
+			}
+			~font_face() {
+				// the faces left open after TTF_Quit are released with the library
+				TTF_Font* f = font_.load();
+				std::lock_guard<std::mutex> t(ttf_lock());
+				if (f && TTF_WasInit()) TTF_CloseFont(f);
 			}
 		};
 
+		// handle to a shared font face. the face is opened, when the font is
+		// first used for measuring or drawing. the default font has no face.
 		class font {
 		private:
-			std::shared_ptr<TTF_Font> font_;
+			std::shared_ptr<font_face> face_;
 		public:
-			font(const char* path, int size)
-			: font_(TTF_OpenFont(path, size), TTF_CloseFont){}
+			font() {}
+			font(const char* path, int size, int style = TTF_STYLE_NORMAL);
+			font(std::shared_ptr<font_face> face)
+			: face_(std::move(face)) {}
 			operator TTF_Font* () const {
-				return font_.get();
+				return face_ ? face_->get() : nullptr;
+			}
+			const std::shared_ptr<font_face>& face() const {
+				return face_;
 			}
 			~font() {}
 		};
 
+		struct font_spec {
+			std::string path_;
+			int size_;
+			int style_;
+			font_spec(const std::string& path, int size, int style = TTF_STYLE_NORMAL)
+			: path_(path), size_(size), style_(style) {}
+		};
+
+		// the loaded font faces keyed by path, point size and style. the fonts
+		// with the same key share one face, and the faces can be opened in
+		// background thread at startup.
+		class font_registry {
+		private:
+			typedef std::tuple<std::string, int, int> key_type;
+			std::mutex lock_;
+			std::map<key_type, std::shared_ptr<font_face>> faces_;
+			std::thread preload_;
+		public:
+			static font_registry& instance() {
+				static font_registry r;
+				return r;
+			}
+			std::shared_ptr<font_face> face(const std::string& path, int size, int style = TTF_STYLE_NORMAL) {
+				std::lock_guard<std::mutex> l(lock_);
+				std::shared_ptr<font_face>& f = faces_[key_type(path, size, style)];
+				if (!f) f = std::make_shared<font_face>(path, size, style);
+				return f;
+			}
+			font get(const std::string& path, int size, int style = TTF_STYLE_NORMAL) {
+				return font(face(path, size, style));
+			}
+			// opens the fonts in background. the fonts, that fail to open, are
+			// left to fail again on their first use.
+			void preload(const std::vector<font_spec>& fonts) {
+				wait();
+				std::vector<std::shared_ptr<font_face>> faces;
+				for (const font_spec& s : fonts) {
+					faces.push_back(face(s.path_, s.size_, s.style_));
+				}
+				preload_ = std::thread([faces]() {
+					for (auto& f : faces) {
+						try {
+							f->get();
+						} catch (const std::runtime_error& ) {}
+					}
+				});
+			}
+			// waits until the preloading is done
+			void wait() {
+				if (preload_.joinable()) preload_.join();
+			}
+			size_t size() {
+				std::lock_guard<std::mutex> l(lock_);
+				return faces_.size();
+			}
+			size_t loaded() {
+				std::lock_guard<std::mutex> l(lock_);
+				size_t rv = 0;
+				for (auto& f : faces_) rv += f.second->loaded();
+				return rv;
+			}
+			// drops the registry's references to the faces
+			void clear() {
+				wait();
+				std::lock_guard<std::mutex> l(lock_);
+				faces_.clear();
+			}
+			~font_registry() {
+				wait();
+			}
+		};
+
+		inline font::font(const char* path, int size, int style)
+		: face_(font_registry::instance().face(path, size, style)) {}
+
+		inline sdltoys::~sdltoys() {
+			font_registry::instance().clear();
+			std::lock_guard<std::mutex> t(font_face::ttf_lock());
+			if (TTF_WasInit()) TTF_Quit();
+			SDL_Quit();
+		}
+
 		class graphics {
 		public:
 			typedef translation_sentry<graphics> translation_sentry_type;
+			typedef clip_sentry<graphics> clip_sentry_type;
 		private:
 			SDL_Renderer* ren_;
-			SDL_Surface* sur_;
 			vec tr_;
+			// the window area or the intersection of the clips pushed
+			SDL_Rect clip_;
+			std::vector<SDL_Rect> clips_;
+			// whether this draws a frame on the window or a layer
+			bool frame_;
+			graphics(SDL_Renderer* ren, const vec& size)
+			: ren_(ren), tr_(), clip_{0, 0, size.x(), size.y()}, clips_(), frame_(false) {}
+			// SDL takes an empty clip rectangle for no clipping at all, so an empty
+			// clip keeps the innermost non-empty one and its drawing is culled
+			void apply_clip() {
+				const SDL_Rect* r = 0;
+				for (size_t i = clips_.size(); i > 0 && !r; --i) {
+					const SDL_Rect& c = i == clips_.size() ? clip_ : clips_[i];
+					if (c.w > 0 && c.h > 0) r = &c;
+				}
+				SDL_RenderSetClipRect(ren_, r);
+			}
 		public:
-			graphics(SDL_Renderer* ren, SDL_Surface* sur) : ren_(ren), sur_(sur), tr_() {
+			// off-screen drawing in a texture with alpha
+			struct layer {
+				std::shared_ptr<SDL_Texture> tex_;
+				vec sz_;
+			};
+			// draws a frame on the window. the window area is the renderer's
+			// current output size, so it follows the resizes.
+			graphics(SDL_Renderer* ren)
+			: ren_(ren), tr_(), clip_(), clips_(), frame_(true) {
+				if (SDL_GetRendererOutputSize(ren_, &clip_.w, &clip_.h)) {
+					clip_.w = clip_.h = std::numeric_limits<int>::max() / 2;
+				}
+				SDL_RenderClear(ren_);
+			}
+			template <typename _draw>
+			void render_layer(layer& l, const vec& size, const _draw& draw) {
+				if (size.x() <= 0 || size.y() <= 0) {
+					l.tex_.reset();
+					return;
+				}
+				if (!l.tex_ || l.sz_.x() != size.x() || l.sz_.y() != size.y()) {
+					l.tex_.reset(SDL_CreateTexture(ren_, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+												   size.x(), size.y()),
+								 SDL_DestroyTexture);
+					if (!l.tex_) {
+						throw std::runtime_error("creating SDL layer texture failed");
+					}
+					SDL_SetTextureBlendMode(l.tex_.get(), SDL_BLENDMODE_BLEND);
+					l.sz_ = vec(size.x(), size.y());
+				}
+				SDL_Texture* target = SDL_GetRenderTarget(ren_);
+				SDL_SetRenderTarget(ren_, l.tex_.get());
+				SDL_RenderSetClipRect(ren_, 0);
+				SDL_SetRenderDrawColor(ren_, 0, 0, 0, 0);
 				SDL_RenderClear(ren_);
+				{
+					graphics g(ren_, size);
+					draw(g);
+				}
+				SDL_SetRenderTarget(ren_, target);
+				apply_clip();
+			}
+			void blit_layer(const layer& l) {
+				if (!l.tex_ || culled(l.sz_)) return;
+				SDL_Rect r = { tr_.x(), tr_.y(), l.sz_.x(), l.sz_.y() };
+				SDL_RenderCopy(ren_, l.tex_.get(), 0, &r);
+			}
+			void push_clip(const vec& size) {
+				clips_.push_back(clip_);
+				int x0 = std::max(clip_.x, tr_.x()), y0 = std::max(clip_.y, tr_.y());
+				int x1 = std::min(clip_.x + clip_.w, tr_.x() + size.x());
+				int y1 = std::min(clip_.y + clip_.h, tr_.y() + size.y());
+				clip_ = SDL_Rect{x0, y0, std::max(0, x1 - x0), std::max(0, y1 - y0)};
+				apply_clip();
+			}
+			void pop_clip() {
+				clip_ = clips_.back();
+				clips_.pop_back();
+				apply_clip();
+			}
+			clip_sentry_type clip(const vec& size) {
+				return clip_sentry_type(*this, size);
+			}
+			// whether the rectangle of size at the current translation is fully clipped
+			bool culled(const vec& size) const {
+				return clip_.w <= 0 || clip_.h <= 0
+					|| tr_.x() >= clip_.x + clip_.w || tr_.y() >= clip_.y + clip_.h
+					|| tr_.x() + size.x() <= clip_.x || tr_.y() + size.y() <= clip_.y;
 			}
 			~graphics() {
-				SDL_RenderPresent(ren_);
+				if (frame_) SDL_RenderPresent(ren_);
 			}
 			SDL_Renderer* renderer() { return ren_; }
 			inline void translate(const vec& t) {
@@ -83,25 +334,200 @@ namespace toys {
 			vec tr() const {
 				return tr_;
 			}
-			inline SDL_Surface* surface() const {
-				return sur_;
+		};
+
+		// writes the input events with their times in ms from the start of
+		// the recording in a text file, one event per line
+		class event_recorder {
+		private:
+			std::ofstream out_;
+			Uint32 start_;
+		public:
+			event_recorder(const std::string& path)
+			: out_(path.c_str()), start_(SDL_GetTicks()) {}
+			void record(const SDL_Event& e) {
+				Uint32 t = SDL_GetTicks() - start_;
+				switch (e.type) {
+				case SDL_MOUSEBUTTONDOWN:
+				case SDL_MOUSEBUTTONUP:
+					out_<<t<<(e.type == SDL_MOUSEBUTTONDOWN ? " down " : " up ")
+						<<e.button.x<<" "<<e.button.y<<" "<<int(e.button.button)<<"\n";
+					break;
+				case SDL_MOUSEMOTION:
+					out_<<t<<" motion "<<e.motion.x<<" "<<e.motion.y<<" 0\n";
+					break;
+				case SDL_QUIT:
+					out_<<t<<" quit 0 0 0\n";
+					break;
+				}
 			}
 		};
 
+		// feeds recorded events to a reactor
+		class event_replay {
+		private:
+			struct entry {
+				Uint32 time_;
+				SDL_Event event_;
+			};
+			std::vector<entry> events_;
+		public:
+			event_replay() : events_() {}
+			// returns false, if there is no recording in the path
+			bool load(const std::string& path) {
+				std::ifstream in(path.c_str());
+				Uint32 t;
+				std::string type;
+				int x, y, button;
+				events_.clear();
+				while (in>>t>>type>>x>>y>>button) {
+					entry e = {t, SDL_Event()};
+					if (type == "down" || type == "up") {
+						e.event_.button.type = type == "down" ? SDL_MOUSEBUTTONDOWN : SDL_MOUSEBUTTONUP;
+						e.event_.button.x = x;
+						e.event_.button.y = y;
+						e.event_.button.button = Uint8(button);
+					} else if (type == "motion") {
+						e.event_.motion.type = SDL_MOUSEMOTION;
+						e.event_.motion.x = x;
+						e.event_.motion.y = y;
+					} else if (type == "quit") {
+						e.event_.type = SDL_QUIT;
+					} else {
+						continue;
+					}
+					events_.push_back(e);
+				}
+				return !events_.empty();
+			}
+			size_t size() const {
+				return events_.size();
+			}
+			// with timed replay, the events are delayed to their recorded times.
+			// otherwise they are fed as fast as the reactor handles them.
+			template <typename _reactor>
+			int run(_reactor& r, bool timed = false) {
+				system::init();
+				Uint32 start = SDL_GetTicks();
+				for (const entry& e : events_) {
+					if (system::exiting()) break;
+					Uint32 now = SDL_GetTicks() - start;
+					if (timed && e.time_ > now) SDL_Delay(e.time_ - now);
+					r.dispatch(e.event_);
+				}
+				return system::exit_value();
+			}
+		};
+
+		// the user event type, which wakes the reactors up for the posted tasks
+		inline Uint32 wake_event_type() {
+			static Uint32 type = SDL_RegisterEvents(1);
+			return type;
+		}
+
+		// tasks posted from any thread to be run in the ui thread. at most one
+		// wake up event is queued at a time, so the posts in between the wake
+		// up and the run coalesce into the same batch.
+		class task_queue {
+			public:
+				typedef std::function<void()> task;
+				// tasks run per wake up, so that a flood of tasks leaves turns for the input
+				static const size_t max_batch = 1024;
+			private:
+				mpsc_queue<task> tasks_;
+				std::atomic<bool> woken_;
+				size_t batches_;
+				void wake() {
+					if (woken_.exchange(true, std::memory_order_acq_rel)) return;
+					SDL_Event e = SDL_Event();
+					e.type = wake_event_type();
+					e.user.data1 = this;
+					if (SDL_PushEvent(&e) <= 0) { // full event queue, let a later post retry
+						woken_.store(false, std::memory_order_release);
+					}
+				}
+			public:
+				task_queue() : tasks_(), woken_(false), batches_() {
+					wake_event_type(); // registered in the ui thread
+				}
+				// can be called from any thread
+				void post(task t) {
+					tasks_.push(std::move(t));
+					wake();
+				}
+				bool wakes(const SDL_Event& e) const {
+					return e.type == wake_event_type() && e.user.data1 == this;
+				}
+				// runs a batch of tasks in the ui thread and returns their count
+				size_t run() {
+					// cleared first, so that a task posted during the batch wakes again
+					woken_.store(false, std::memory_order_release);
+					task t;
+					size_t n = 0;
+					while (n < max_batch && tasks_.pop(t)) {
+						t();
+						n++;
+					}
+					if (!tasks_.empty()) wake();
+					if (n) batches_++;
+					return n;
+				}
+				// batches of tasks run so far
+				size_t batches() const {
+					return batches_;
+				}
+		};
+
 		template <typename _recvr>
 		class reactor {
+		public:
+			typedef task_queue::task task;
 		private:
 			_recvr toy_;
+			event_recorder* recorder_;
+			task_queue tasks_;
 		public:
-			reactor(const _recvr& t) : toy_(t) {}
+			reactor(const _recvr& t) : toy_(t), recorder_(), tasks_() {}
+			// records the dispatched events until set back to null
+			void record(event_recorder* r) {
+				recorder_ = r;
+			}
+			// runs the task in the ui thread and redraws after it. can be called
+			// from any thread. the tasks posted close together run as a batch
+			// followed by a single redraw.
+			void post(task t) {
+				tasks_.post(std::move(t));
+			}
+			size_t batches() const {
+				return tasks_.batches();
+			}
+			void dispatch(const SDL_Event& event) {
+				if (recorder_) recorder_->record(event);
+				if (event.type == SDL_MOUSEBUTTONDOWN) {
+					click e(xy(event.button.x, event.button.y));
+					toy_->recv(vec(), e);
+				} else if (event.type == SDL_QUIT) {
+					system::exit(0);
+				} else if (tasks_.wakes(event)) {
+					if (tasks_.run()) toy_->draw();
+				}
+			}
+			// while the receiver animates, the events are handled in between its
+			// frames. otherwise the reactor sleeps until the next event.
 			int run() {
 				system::init();
 				while (!system::exiting()) {
 					SDL_Event event;
-					SDL_WaitEvent(&event);
-					if (event.type == SDL_MOUSEBUTTONDOWN) {
-						click e(xy(event.button.x, event.button.y));
-						toy_->recv(vec(), e);
+					if (toy_->animating()) {
+						int wait = toy_->until_frame();
+						if (wait > 0 && SDL_WaitEventTimeout(&event, wait)) {
+							dispatch(event);
+						} else {
+							toy_->frame();
+						}
+					} else {
+						SDL_WaitEvent(&event);
+						dispatch(event);
 					}
 				}
 				return system::exit_value();
@@ -115,7 +541,7 @@ namespace toys {
 				typedef gen::itoy<traits> base_type;
 				typedef rgba 		 pixel_type;
 				typedef graphics 	 graphics_type;
-				typedef TTF_Font*    font_type;
+				typedef font         font_type;
 				typedef rgba 		 color_type;
 		};
 
@@ -126,10 +552,13 @@ namespace toys {
 				typedef gen::stoy    base_type;
 				typedef rgba 		 pixel_type;
 				typedef graphics 	 graphics_type;
-				typedef TTF_Font*    font_type;
+				typedef font         font_type;
 				typedef rgba 		 color_type;
 		};
 
+		// value type for storing heterogeneous toys without heap allocations
+		typedef gen::any_toy<baseless_traits> any_toy;
+
 		template <typename _tref>
 		std::unique_ptr<itoy> owned_itoy(_tref t) {
 			return std::unique_ptr<itoy>(new gen::wrap<traits, _tref>(t));
@@ -140,51 +569,255 @@ namespace toys {
 			return std::shared_ptr<itoy>(new gen::wrap<traits, _tref>(t));
 		};
 
+		// timings of the latest frames in microseconds. the events phase
+		// covers the event handling since the previous frame, draw covers the
+		// clearing and the draw calls of the toys and present covers
+		// presenting the frame. a histogram of the timings in the window is kept
+		// up to date as the old frames roll out.
+		class frame_stats {
+		public:
+			enum phase { events, draw, present, total, phase_count };
+			static const size_t frames = 128;
+			// bucket 0 is below 1us and bucket i covers [2^(i-1), 2^i) us
+			static const size_t buckets = 16;
+		private:
+			uint32_t us_[phase_count][frames];
+			size_t hist_[phase_count][buckets];
+			size_t count_;
+			uint32_t pending_events_;
+		public:
+			frame_stats() : us_(), hist_(), count_(), pending_events_() {}
+			static uint64_t now() {
+				return SDL_GetPerformanceCounter();
+			}
+			static uint32_t us(uint64_t begin, uint64_t end) {
+				return uint32_t(((end - begin) * 1000000) / SDL_GetPerformanceFrequency());
+			}
+			static size_t bucket(uint32_t us) {
+				size_t b = 0;
+				while (us && b + 1 < buckets) {
+					us >>= 1;
+					b++;
+				}
+				return b;
+			}
+			static const char* name(phase p) {
+				static const char* names[phase_count] = {"events", "draw", "present", "total"};
+				return names[p];
+			}
+			// event handling gets accumulated until the next frame ends
+			void add_events(uint32_t us) {
+				pending_events_ += us;
+			}
+			void add_frame(uint32_t draw_us, uint32_t present_us) {
+				uint32_t f[phase_count] = {pending_events_, draw_us, present_us,
+										   pending_events_ + draw_us + present_us};
+				size_t slot = count_ % frames;
+				for (size_t p = 0; p < phase_count; ++p) {
+					if (count_ >= frames) hist_[p][bucket(us_[p][slot])]--;
+					us_[p][slot] = f[p];
+					hist_[p][bucket(f[p])]++;
+				}
+				count_++;
+				pending_events_ = 0;
+			}
+			// number of frames in the window
+			size_t size() const {
+				return count_ < frames ? count_ : frames;
+			}
+			// number of frames recorded in total
+			size_t count() const {
+				return count_;
+			}
+			// timing of frame i in the window, where 0 is the oldest frame
+			uint32_t at(size_t i, phase p) const {
+				return us_[p][(count_ - size() + i) % frames];
+			}
+			uint32_t last(phase p) const {
+				return count_ ? at(size() - 1, p) : 0;
+			}
+			uint32_t percentile(phase p, double r) const {
+				size_t n = size();
+				if (!n) return 0;
+				std::vector<uint32_t> v(n);
+				for (size_t i = 0; i < n; ++i) v[i] = at(i, p);
+				size_t k = std::min(n - 1, size_t(r * n));
+				std::nth_element(v.begin(), v.begin() + k, v.end());
+				return v[k];
+			}
+			const size_t* histogram(phase p) const {
+				return hist_[p];
+			}
+		};
+
+		// overlay of the frame timings: the latest frames as bars stacked from
+		// the events, draw and present timings, a line at the 60 fps budget
+		// and the median and 90th percentile of the frame times as text
+		template <typename _traits>
+		class frame_hud : public _traits::base_type {
+			public:
+				typedef typename _traits::graphics_type graphics_type;
+				static const int us_per_pixel = 250;
+				static const int budget_us = 16667;
+			private:
+				const frame_stats& stats_;
+				font font_;
+			public:
+				frame_hud(const frame_stats& stats, const font& f)
+				: stats_(stats), font_(f) {}
+				vec size(const vec& ) const {
+					return vec(frame_stats::frames, 100);
+				}
+				void draw(const vec& size, graphics_type& g) const {
+					typedef box<_traits, value_copy> x;
+					const rgba colors[] = {{250, 150, 50, 255}, {50, 150, 250, 255}, {100, 220, 100, 255}};
+					x::rc(rgba{0, 0, 0, 255})->draw(size, g);
+					for (size_t i = 0; i < stats_.size(); ++i) {
+						int y = size.y();
+						for (auto p : {frame_stats::events, frame_stats::draw, frame_stats::present}) {
+							int h = std::min(y, int(stats_.at(i, p) / us_per_pixel));
+							y -= h;
+							x::at(vec(int(i), y), x::sz(vec(1, h), x::rc(colors[p])))->draw(size, g);
+						}
+					}
+					int budget = size.y() - budget_us / us_per_pixel;
+					x::at(vec(0, budget), x::sz(vec(size.x(), 1), x::rc(rgba{250, 50, 50, 255})))->draw(size, g);
+					std::ostringstream buf;
+					buf<<"p50 "<<stats_.percentile(frame_stats::total, .5) / 1000.
+					   <<" p90 "<<stats_.percentile(frame_stats::total, .9) / 1000.<<" ms";
+					x::tx(buf.str(), font_, rgba{255, 255, 255, 255})->draw(size, g);
+				}
+		};
+
+		// the windows as seen by the multi_reactor
+		class iwindow {
+			public:
+				virtual ~iwindow() {}
+				virtual Uint32 id() const = 0;
+				// sends the event to the toy without drawing. the window gets
+				// dirty, if the toy handled the event.
+				virtual bool handle(ievent& e) = 0;
+				virtual void draw() const = 0;
+				// the window needs to be drawn
+				virtual bool dirty() const = 0;
+				virtual void invalidate() = 0;
+				virtual bool animating() const = 0;
+				virtual int until_frame() const = 0;
+				virtual void frame() = 0;
+				// hides the closed window, which gets no more events
+				virtual void hide() = 0;
+		};
+
 		template <typename _toyr>
-		class window {
+		class window : public iwindow {
 		private:
 			SDL_Window* win_;
 			SDL_Renderer* ren_;
-			SDL_Surface* sur_;
 			_toyr toy_;
+			mutable frame_stats stats_;
+			font hud_;
+			anim::frame_clock clock_;
+			Uint32 frame_time_;
+			mutable bool dirty_;
 
 		public:
+			// frame interval of the animations, when the present doesn't wait for the vsync
+			static const Uint32 frame_ms = 16;
+
 			window(const char* name, vec pos, vec size, const _toyr& toy)
-		   : win_(), ren_(), sur_(), toy_(toy) {
+		   : win_(), ren_(), toy_(toy), stats_(), hud_(), clock_(), frame_time_(), dirty_(true) {
 				win_ = SDL_CreateWindow(name, pos.x(), pos.y(), size.x(), size.y(), SDL_WINDOW_SHOWN);
 				if (!win_) {
 					throw std::runtime_error("creating SDL window failed");
 				}
 				ren_ = SDL_CreateRenderer( win_, -1, SDL_RENDERER_ACCELERATED
 											 	   | SDL_RENDERER_PRESENTVSYNC );
+				if (!ren_) { // e.g. the dummy video driver has no accelerated renderers
+					ren_ = SDL_CreateRenderer( win_, -1, SDL_RENDERER_SOFTWARE );
+				}
 				if (!ren_) {
 					SDL_DestroyWindow(win_);
 					throw std::runtime_error("creating SDL renderer failed");
 				}
-				sur_ = SDL_GetWindowSurface(win_);
-				if (!sur_) {
-					SDL_DestroyWindow(win_);
-					SDL_DestroyRenderer(ren_);
-					throw std::runtime_error("getting window surface failed");
-				}
 			}
 			vec size() const {
 				int w, h;
 				SDL_GetWindowSize( win_, &w, &h );
 				return vec(w, h);
 			};
+			Uint32 id() const {
+				return SDL_GetWindowID(win_);
+			}
+			void hide() {
+				SDL_HideWindow(win_);
+			}
+			bool shown() const {
+				return SDL_GetWindowFlags(win_) & SDL_WINDOW_SHOWN;
+			}
 			void draw() const {
+				dirty_ = false;
+				uint64_t begin = frame_stats::now(), drawn;
 				vec sz = size();
-				auto g = graphics();
-				toy_->draw(sz, g);
+				{
+					auto g = graphics();
+					toy_->draw(sz, g);
+					drawn = frame_stats::now();
+					if (hud_.face()) {
+						frame_hud<baseless_traits> h(stats_, hud_);
+						vec hsz = h.size(sz);
+						auto ts = g.translation(vec(sz.x() - hsz.x(), 0));
+						h.draw(hsz, g);
+					}
+				} // the graphics presents the frame, when it's destroyed
+				uint64_t end = frame_stats::now();
+				stats_.add_frame(frame_stats::us(begin, drawn), frame_stats::us(drawn, end));
 			}
-			bool recv(const vec& , ievent& e) {
+			bool handle(ievent& e) {
+				uint64_t begin = frame_stats::now();
 				bool rv = toy_->recv(size(), e);
+				stats_.add_events(frame_stats::us(begin, frame_stats::now()));
+				if (rv) dirty_ = true;
+				return rv;
+			}
+			bool recv(const vec& , ievent& e) {
+				bool rv = handle(e);
 				draw();
 				return rv;
 			}
+			bool dirty() const {
+				return dirty_;
+			}
+			void invalidate() {
+				dirty_ = true;
+			}
+			const frame_stats& stats() const {
+				return stats_;
+			}
+			// the clock of the animations in the window
+			anim::frame_clock& clock() {
+				return clock_;
+			}
+			bool animating() const {
+				return clock_.active();
+			}
+			// milliseconds until the next animation frame is due
+			int until_frame() const {
+				Uint32 since = SDL_GetTicks() - frame_time_;
+				return since < frame_ms ? int(frame_ms - since) : 0;
+			}
+			// steps the animations and draws the frame
+			void frame() {
+				frame_time_ = SDL_GetTicks();
+				clock_.tick();
+				draw();
+			}
+			// shows the frame timings overlay in the top right corner or hides
+			// it with the default font
+			void show_hud(const font& f) {
+				hud_ = f;
+			}
 			::toys::sdl::graphics graphics() const {
-				return ::toys::sdl::graphics(ren_, sur_);
+				return ::toys::sdl::graphics(ren_);
 			}
 			~window() {
 				SDL_DestroyRenderer(ren_);
@@ -192,6 +825,110 @@ namespace toys {
 			}
 		};
 
+		// reactor for several windows of the process. the events are routed to
+		// the windows by their window ids. the windows are drawn after the
+		// queued events are handled, and only the windows that got dirty, so
+		// a burst of events costs one frame per changed window. the windows
+		// share the fonts through the font_registry.
+		class multi_reactor {
+			public:
+				typedef task_queue::task task;
+			private:
+				std::vector<iwindow*> windows_;
+				task_queue tasks_;
+				iwindow* find(Uint32 id) const {
+					for (iwindow* w : windows_) {
+						if (w->id() == id) return w;
+					}
+					return nullptr;
+				}
+				bool animating() const {
+					for (iwindow* w : windows_) {
+						if (w->animating()) return true;
+					}
+					return false;
+				}
+				int until_frame() const {
+					int wait = std::numeric_limits<int>::max();
+					for (iwindow* w : windows_) {
+						if (w->animating()) wait = std::min(wait, w->until_frame());
+					}
+					return wait;
+				}
+			public:
+				multi_reactor() : windows_(), tasks_() {}
+				// the window must outlive the reactor or be removed first
+				void add(iwindow& w) {
+					windows_.push_back(&w);
+				}
+				void remove(iwindow& w) {
+					windows_.erase(std::remove(windows_.begin(), windows_.end(), &w), windows_.end());
+				}
+				size_t size() const {
+					return windows_.size();
+				}
+				// runs the task in the ui thread. the tasks don't know, which
+				// windows they change, so all windows are drawn after a batch.
+				void post(task t) {
+					tasks_.post(std::move(t));
+				}
+				void dispatch(const SDL_Event& event) {
+					if (event.type == SDL_MOUSEBUTTONDOWN) {
+						if (iwindow* w = find(event.button.windowID)) {
+							click e(xy(event.button.x, event.button.y));
+							w->handle(e);
+						}
+					} else if (event.type == SDL_WINDOWEVENT) {
+						iwindow* w = find(event.window.windowID);
+						if (!w) return;
+						switch (event.window.event) {
+						case SDL_WINDOWEVENT_SHOWN:
+						case SDL_WINDOWEVENT_EXPOSED:
+						case SDL_WINDOWEVENT_SIZE_CHANGED:
+							w->invalidate();
+							break;
+						case SDL_WINDOWEVENT_CLOSE:
+							w->hide();
+							remove(*w);
+							if (windows_.empty()) system::exit(0);
+							break;
+						}
+					} else if (event.type == SDL_QUIT) {
+						system::exit(0);
+					} else if (tasks_.wakes(event)) {
+						if (tasks_.run()) {
+							for (iwindow* w : windows_) w->invalidate();
+						}
+					}
+				}
+				void draw_dirty() {
+					for (iwindow* w : windows_) {
+						if (w->dirty()) w->draw();
+					}
+				}
+				int run() {
+					system::init();
+					while (!system::exiting()) {
+						SDL_Event event;
+						if (animating()) {
+							int wait = until_frame();
+							if (wait <= 0 || !SDL_WaitEventTimeout(&event, wait)) {
+								for (iwindow* w : windows_) {
+									if (w->animating()) w->frame();
+								}
+								continue;
+							}
+						} else {
+							SDL_WaitEvent(&event);
+						}
+						dispatch(event);
+						while (!system::exiting() && SDL_PollEvent(&event)) dispatch(event);
+						draw_dirty();
+					}
+					return system::exit_value();
+				}
+		};
+
 		inline const char* utf8_ptr(const char* s) {
 			return s;
 		}
@@ -206,21 +943,39 @@ namespace toys {
 				_font font_;
 				_color color_;
 			public:
-				text(const _text& txt, const _font& font, const _color& color)
-				: txt_(txt), font_(font), color_(color) {}
+				text(_text txt, const _font& font, _color color)
+				: txt_(std::move(txt)), font_(font), color_(std::move(color)) {}
 				vec size(const vec& ) const {
+					trace_scope<_traits> trace("text.size");
 					int w, h;
-					TTF_SizeUTF8(font_, utf8_ptr(txt_), &w, &h);
+					TTF_Font* f = font_;
+					std::lock_guard<std::mutex> l(font_face::ttf_lock());
+					TTF_SizeUTF8(f, utf8_ptr(txt_), &w, &h);
 					return vec(w, h);
 				}
-				void draw(const vec& , graphics& g) const {
-					SDL_Surface* s = TTF_RenderUTF8_Blended(font_,utf8_ptr(txt_), color_);
+				void draw(const vec& size, graphics& g) const {
+					trace_scope<_traits> trace("text.draw");
+					if (g.culled(size)) return;
+					TTF_Font* f = font_;
+					SDL_Surface* s;
+					{
+						std::lock_guard<std::mutex> l(font_face::ttf_lock());
+						s = TTF_RenderUTF8_Blended(f, utf8_ptr(txt_), color_);
+					}
 					SDL_Texture* t = SDL_CreateTextureFromSurface(g.renderer(), s);
 					SDL_Rect r = {g.tr().x(), g.tr().y(), s->w, s->h };
 					SDL_RenderCopy(g.renderer(), t, 0, &r);
 					SDL_DestroyTexture(t);
 					SDL_FreeSurface(s);
 				}
+				static const unsigned interest_mask = 0;
+				static const gen::takes_hits hits = gen::hits_none;
+				unsigned interest() const {
+					return 0;
+				}
+				gen::takes_hits takes() const {
+					return gen::hits_none;
+				}
 		};
 		template <typename _toyr>
 		int sdltoys::run(_toyr t) {
@@ -247,25 +1002,37 @@ namespace toys {
 
 			typedef toys::box<baseless_traits, value_copy> box;
 
-			template <typename _t> auto ref(const _t& t) 				{ return box::ref(t); }
+			template <typename _t> auto ref(_t&& t) 					{ return box::ref(std::forward<_t>(t)); }
 			template <typename _tr, typename _toy_ref>
-			inline auto sz(const _tr& tr, const _toy_ref& ref) 			{ return box::sz( tr, ref); }
+			inline auto sz(_tr&& tr, _toy_ref&& ref) 					{ return box::sz(std::forward<_tr>(tr), std::forward<_toy_ref>(ref)); }
 			template <typename _lambda, typename _toy_ref>
-			inline auto on_click(const _lambda& l, const _toy_ref& ref) { return box::on_click( l, ref); };
+			inline auto on_click(_lambda&& l, _toy_ref&& ref) 			{ return box::on_click(std::forward<_lambda>(l), std::forward<_toy_ref>(ref)); };
 			template <typename _xy, typename _toy_ref>
-			inline auto at(const _xy& xy, const _toy_ref& ref) 			{ return box::at( xy, ref); }
+			inline auto at(const _xy& xy, _toy_ref&& ref) 				{ return box::at(xy, std::forward<_toy_ref>(ref)); }
 			template <typename _xy, typename _toy_ref>
-			inline auto lay(const _xy& xy, const _toy_ref& ref) 		{ return box::lay( xy, ref ); }
+			inline auto lay(const _xy& xy, _toy_ref&& ref) 				{ return box::lay(xy, std::forward<_toy_ref>(ref)); }
+			template <typename _toy_ref>
+			inline auto clip(_toy_ref&& ref) 							{ return box::clip(std::forward<_toy_ref>(ref)); }
+			template <typename _toy_ref>
+			inline auto cached(_toy_ref&& ref) 							{ return box::cached(std::forward<_toy_ref>(ref)); }
+			template <typename _toy_ref>
+			inline auto cached(std::shared_ptr<box::cache_type> cache, _toy_ref&& ref) {
+				return box::cached(std::move(cache), std::forward<_toy_ref>(ref));
+			}
 			template <typename _pixel>
 			inline auto rc(_pixel pixel) 								{ return box::rc(pixel); };
 			template <typename _text, typename _font, typename _color>
-			inline auto tx(const _text& text, const _font& font, const _color& color) { return box::tx(text, font, color); }
+			inline auto tx(_text&& text, const _font& font, const _color& color) { return box::tx(std::forward<_text>(text), font, color); }
 			template <typename _sp, typename _f_ref, typename _s_ref>
-			inline auto lr(_sp sp, const _f_ref& f, const _s_ref& s)    { return box::lr(sp, f, s); };
+			inline auto lr(_sp sp, _f_ref&& f, _s_ref&& s)    			{ return box::lr(sp, std::forward<_f_ref>(f), std::forward<_s_ref>(s)); };
 			template <typename _sp, typename _f_ref, typename _s_ref>
-			static auto ud(_sp sp, const _f_ref& f, const _s_ref& s)    { return box::ud(sp, f, s); }
+			static auto ud(_sp sp, _f_ref&& f, _s_ref&& s)    			{ return box::ud(sp, std::forward<_f_ref>(f), std::forward<_s_ref>(s)); }
 			template <typename _f_ref, typename _s_ref>
-			auto fb(const _f_ref& f, const _s_ref& b) 					{ return box::fb(f, b); }
+			auto fb(_f_ref&& f, _s_ref&& b) 							{ return box::fb(std::forward<_f_ref>(f), std::forward<_s_ref>(b)); }
+			template <typename... _toy_refs>
+			inline auto row(_toy_refs&&... refs) 						{ return box::row(std::forward<_toy_refs>(refs)...); }
+			template <typename... _toy_refs>
+			inline auto col(_toy_refs&&... refs) 						{ return box::col(std::forward<_toy_refs>(refs)...); }
 		}
 	}
 	namespace gen { // necessary specializations
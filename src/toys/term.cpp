@@ -0,0 +1,165 @@
+/*
+ * term.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arau
+ */
+
+#include "toys/term.h"
+#include <ostream>
+#include <string.h>
+#include <stdint.h>
+
+namespace toys {
+	namespace term {
+
+		namespace {
+
+			// rewriting few unchanged cells is cheaper than a cursor move
+			const int max_gap = 4;
+
+			const vec unknown(-1, -1);
+
+			// first cell from i on, where either the characters or the attributes
+			// differ. the cells are compared 8 at a time.
+			int first_diff(const char* a, const char* b, const char* aa, const char* ba, int i, int n) {
+				for (; i + 8 <= n; i += 8) {
+					uint64_t x, y, u, v;
+					memcpy(&x, a + i, 8);
+					memcpy(&y, b + i, 8);
+					memcpy(&u, aa + i, 8);
+					memcpy(&v, ba + i, 8);
+					if ((x ^ y) | (u ^ v)) break;
+				}
+				for (; i < n; ++i) {
+					if (a[i] != b[i] || aa[i] != ba[i]) break;
+				}
+				return i;
+			}
+
+			void append_int(std::string& s, int v) {
+				char buf[16];
+				int n = 0;
+				do {
+					buf[n++] = char('0' + v % 10);
+					v /= 10;
+				} while (v);
+				while (n) s += buf[--n];
+			}
+
+		}
+
+		screen::screen(const vec& sz)
+		: sz_(), back_(), back_attrs_(), front_(), front_attrs_(),
+		  g_(vec(), 0), attrs_g_(vec(), 0), full_(true), out_(), cursor_(unknown), attr_(-1), changed_() {
+			resize(sz);
+		}
+
+		void screen::resize(const vec& sz) {
+			sz_ = vec(sz.x(), sz.y(), 1);
+			back_.assign(sz_.volume(), ' ');
+			back_attrs_.assign(sz_.volume(), 0);
+			front_.assign(sz_.volume(), ' ');
+			front_attrs_.assign(sz_.volume(), 0);
+			g_ = text_graphics(sz_, back_.data());
+			attrs_g_ = text_graphics(sz_, back_attrs_.data());
+			full_ = true;
+		}
+
+		void screen::clear(char c) {
+			memset(back_.data(), c, back_.size());
+			memset(back_attrs_.data(), 0, back_attrs_.size());
+		}
+
+		void screen::move(int x, int y) {
+			if (cursor_.x() == x && cursor_.y() == y) return;
+			if (cursor_.y() == y && cursor_.x() >= 0 && x > cursor_.x()) {
+				out_ += "\x1b[";
+				append_int(out_, x - cursor_.x());
+				out_ += 'C';
+			} else {
+				out_ += "\x1b[";
+				append_int(out_, y + 1);
+				out_ += ';';
+				append_int(out_, x + 1);
+				out_ += 'H';
+			}
+			cursor_ = vec(x, y);
+		}
+
+		void screen::set_attr(char a) {
+			if (attr_ == (a & 0xff)) return;
+			int fg = a & 0xf, bg = (a >> 4) & 0xf;
+			out_ += "\x1b[0";
+			if (fg) {
+				out_ += ";3";
+				out_ += char('0' + fg - 1);
+			}
+			if (bg) {
+				out_ += ";4";
+				out_ += char('0' + bg - 1);
+			}
+			out_ += 'm';
+			attr_ = a & 0xff;
+		}
+
+		void screen::write_span(int y, int begin, int end) {
+			move(begin, y);
+			const char* b = &back_[y * sz_.x()];
+			const char* ba = &back_attrs_[y * sz_.x()];
+			for (int x = begin; x < end; ++x) {
+				set_attr(ba[x]);
+				out_ += (b[x] >= ' ' && b[x] != 0x7f) ? b[x] : ' ';
+			}
+			changed_ += end - begin;
+			// the cursor position is ambiguous after writing the last column
+			cursor_ = end < sz_.x() ? vec(end, y) : unknown;
+		}
+
+		void screen::present_row(int y) {
+			int w = sz_.x();
+			char* f = &front_[y * w];
+			char* fa = &front_attrs_[y * w];
+			const char* b = &back_[y * w];
+			const char* ba = &back_attrs_[y * w];
+			if (!memcmp(b, f, w) && !memcmp(ba, fa, w)) return;
+			int x = first_diff(b, f, ba, fa, 0, w);
+			while (x < w) {
+				// extend the span over short gaps of unchanged cells
+				int last = x;
+				for (int i = x + 1; i < w && i - last <= max_gap; ++i) {
+					if (b[i] != f[i] || ba[i] != fa[i]) last = i;
+				}
+				write_span(y, x, last + 1);
+				x = first_diff(b, f, ba, fa, last + 1, w);
+			}
+			memcpy(f, b, w);
+			memcpy(fa, ba, w);
+		}
+
+		const std::string& screen::present() {
+			out_.clear();
+			changed_ = 0;
+			if (full_) {
+				// after clearing, the terminal shows spaces in default colors
+				out_ += "\x1b[0m\x1b[2J";
+				attr_ = 0;
+				cursor_ = unknown;
+				memset(front_.data(), ' ', front_.size());
+				memset(front_attrs_.data(), 0, front_attrs_.size());
+				full_ = false;
+			}
+			for (int y = 0; y < sz_.y(); ++y) {
+				present_row(y);
+			}
+			return out_;
+		}
+
+		void screen::present(std::ostream& o) {
+			const std::string& s = present();
+			o.write(s.data(), s.size());
+			o.flush();
+		}
+
+	}
+}
@@ -0,0 +1,82 @@
+/*
+ * term.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arau
+ */
+
+#ifndef TOYS_TERM_H
+#define TOYS_TERM_H
+
+#include "toys/text.h"
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace toys {
+	namespace term {
+
+		// attribute byte of a cell: the low nibble is the foreground and the
+		// high nibble the background color. 0 is the terminal's default color
+		// and 1-8 are the ansi colors black, red, green, yellow, blue, magenta,
+		// cyan and white.
+		inline char attr(int fg, int bg = 0) {
+			return char((fg & 0xf) | ((bg & 0xf) << 4));
+		}
+
+		// double buffered terminal screen. the toys draw the characters in
+		// the back buffer through text_graphics and optionally the colors in
+		// the attribute plane, which is another text_graphics over attribute
+		// bytes. present() compares the back buffer with the front buffer,
+		// which holds what the terminal shows, and emits only the cursor moves,
+		// color changes and writes needed for the changed cells.
+		class screen {
+			private:
+				vec sz_;
+				std::vector<char> back_;
+				std::vector<char> back_attrs_;
+				std::vector<char> front_;
+				std::vector<char> front_attrs_;
+				text_graphics g_;
+				text_graphics attrs_g_;
+				bool full_;
+				std::string out_;
+				vec cursor_;
+				int attr_;
+				size_t changed_;
+
+				void move(int x, int y);
+				void set_attr(char a);
+				void write_span(int y, int begin, int end);
+				void present_row(int y);
+			public:
+				screen(const vec& sz);
+				vec size() const {
+					return vec(sz_.x(), sz_.y());
+				}
+				text_graphics& g() {
+					return g_;
+				}
+				text_graphics& attrs() {
+					return attrs_g_;
+				}
+				// resets the back buffer to c with default colors
+				void clear(char c = ' ');
+				// forgets what the terminal shows, so that the next frame gets fully drawn
+				void invalidate() {
+					full_ = true;
+				}
+				void resize(const vec& sz);
+				// the escape sequences to update the terminal to the back buffer
+				const std::string& present();
+				void present(std::ostream& o);
+				// cells written by the latest present
+				size_t changed() const {
+					return changed_;
+				}
+		};
+
+	}
+}
+
+#endif
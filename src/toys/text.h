@@ -9,25 +9,65 @@
 #define TEXT_H_
 
 #include "toys/toys.h"
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include <vector>
+#include <string.h>
 
 namespace toys {
 
 	struct text_graphics {
 	public:
 		typedef translation_sentry<text_graphics> translation_sentry_type;
+		typedef clip_sentry<text_graphics> clip_sentry_type;
+		// off-screen drawing, where the zero characters are transparent
+		struct layer {
+			vec sz_;
+			std::vector<char> buf_;
+		};
 	private:
 		vec sz_;
 		char* buf_;
 		vec tr_;
+		// the clip rectangle in buffer coordinates and the outer clips
+		vec clip_begin_;
+		vec clip_end_;
+		std::vector<std::pair<vec, vec>> clips_;
+		inline bool clipped(const vec& p) const {
+			return p.x() < clip_begin_.x() || p.y() < clip_begin_.y()
+				|| p.x() >= clip_end_.x() || p.y() >= clip_end_.y()
+				|| p.z() < 0 || p.z() >= sz_.z();
+		}
 	public:
 		inline text_graphics(const vec& sz, char* buf)
-		: sz_(sz), buf_(buf), tr_() {}
+		: sz_(sz), buf_(buf), tr_(), clip_begin_(), clip_end_(sz), clips_() {}
 		inline void set(vec p, char c) {
 			p += tr_;
-			if (sz_.contains(p)) {
+			if (!clipped(p)) {
 				buf_[p.x() + sz_.x()*p.y()] = c;
 			}
 		}
+		inline void push_clip(const vec& size) {
+			clips_.push_back(std::make_pair(clip_begin_, clip_end_));
+			clip_begin_ = vec(std::max(clip_begin_.x(), tr_.x()),
+							  std::max(clip_begin_.y(), tr_.y()), clip_begin_.z());
+			clip_end_ = vec(std::max(clip_begin_.x(), std::min(clip_end_.x(), tr_.x() + size.x())),
+							std::max(clip_begin_.y(), std::min(clip_end_.y(), tr_.y() + size.y())), clip_end_.z());
+		}
+		inline void pop_clip() {
+			clip_begin_ = clips_.back().first;
+			clip_end_ = clips_.back().second;
+			clips_.pop_back();
+		}
+		inline clip_sentry_type clip(const vec& size) {
+			return clip_sentry_type(*this, size);
+		}
+		// whether the rectangle of size at the current translation is fully clipped
+		inline bool culled(const vec& size) const {
+			return tr_.x() >= clip_end_.x() || tr_.y() >= clip_end_.y()
+				|| tr_.x() + size.x() <= clip_begin_.x() || tr_.y() + size.y() <= clip_begin_.y();
+		}
 		inline void translate(const vec& t) {
 			tr_ += t;
 		}
@@ -42,6 +82,74 @@ namespace toys {
 			}
 			return rv;
 		}
+		// clips the row span of len cells starting from p. returns the first
+		// visible cell in the buffer or null, when nothing is visible. skip is
+		// set to the count of the cells clipped from the span's beginning.
+		inline char* span(vec p, int& skip, int& len) {
+			p += tr_;
+			if (p.y() < clip_begin_.y() || p.y() >= clip_end_.y() || p.z() < 0 || p.z() >= sz_.z()) return 0;
+			skip = std::max(0, clip_begin_.x() - p.x());
+			len = std::min(clip_end_.x(), p.x() + len) - (p.x() + skip);
+			return len > 0 ? buf_ + p.x() + skip + sz_.x()*p.y() : 0;
+		}
+		inline void fill_span(const vec& p, int len, char c) {
+			int skip;
+			if (char* to = span(p, skip, len)) {
+				memset(to, c, len);
+			}
+		}
+		// fills the rectangle of size from p. the rectangle is clipped once
+		// and the visible part of each row is filled with memset
+		inline void fill(vec p, const vec& size, char c) {
+			p += tr_;
+			if (p.z() < 0 || p.z() >= sz_.z()) return;
+			int x0 = std::max(clip_begin_.x(), p.x()), x1 = std::min(clip_end_.x(), p.x() + size.x());
+			int y0 = std::max(clip_begin_.y(), p.y()), y1 = std::min(clip_end_.y(), p.y() + size.y());
+			for (int y = y0; y < y1 && x0 < x1; ++y) {
+				memset(buf_ + x0 + sz_.x()*y, c, x1 - x0);
+			}
+		}
+		// writes the characters from begin to end on the row from p on
+		template <typename _it>
+		inline void blit(const vec& p, _it begin, _it end) {
+			int skip, len = int(std::distance(begin, end));
+			if (char* to = span(p, skip, len)) {
+				std::advance(begin, skip);
+				_it last = begin;
+				std::advance(last, len);
+				std::copy(begin, last, to);
+			}
+		}
+		inline void blit(const vec& p, const char* s, int len) {
+			int skip;
+			if (char* to = span(p, skip, len)) {
+				memcpy(to, s + skip, len);
+			}
+		}
+		template <typename _draw>
+		inline void render_layer(layer& l, const vec& size, const _draw& draw) {
+			l.sz_ = vec(std::max(0, size.x()), std::max(0, size.y()), 1);
+			l.buf_.assign(l.sz_.volume(), '\0');
+			text_graphics g(l.sz_, l.buf_.data());
+			draw(g);
+		}
+		// draws the layer at the current translation. the fully opaque
+		// rows are copied at once
+		inline void blit_layer(const layer& l) {
+			for (int y = 0; y < l.sz_.y(); ++y) {
+				int skip, len = l.sz_.x();
+				if (char* to = span(vec(0, y), skip, len)) {
+					const char* from = l.buf_.data() + y * l.sz_.x() + skip;
+					if (!memchr(from, 0, len)) {
+						memcpy(to, from, len);
+					} else {
+						for (int i = 0; i < len; ++i) {
+							if (from[i]) to[i] = from[i];
+						}
+					}
+				}
+			}
+		}
 	};
 	struct text_traits {
 		public:
@@ -64,12 +172,8 @@ namespace toys {
 	namespace gen {
 
 		template <>
-		void fill_rect(text_graphics& g, const vec& size, char c) {
-			for (int y = 0; y < size.y(); ++y) {
-				for (int x = 0; x < size.x(); ++x) {
-					g.set(vec(x, y), c);
-				}
-			}
+		inline void fill_rect(text_graphics& g, const vec& size, char c) {
+			g.fill(vec(), size, c);
 		}
 
 		template <typename _traits, typename _text>
@@ -77,31 +181,32 @@ namespace toys {
 			private:
 				_text txt_;
 			public:
-				text_text(const _text& txt, const nothing& font = nothing(), const nothing& color = nothing())
-				: txt_(txt) {}
+				text_text(_text txt, const nothing& font = nothing(), const nothing& color = nothing())
+				: txt_(std::move(txt)) {}
 				vec size(const vec& ) const {
+					trace_scope<_traits> trace("text.size");
 					return vec(txt_.end() - txt_.begin(), 1);
 				}
 				void draw(const vec& , text_graphics& g) const {
-					int i = 0;
-					for (auto c : txt_) {
-						g.set(vec(i, 0), c);
-						i++;
-					}
+					trace_scope<_traits> trace("text.draw");
+					g.blit(vec(), txt_.begin(), txt_.end());
+				}
+				static const unsigned interest_mask = 0;
+				static const takes_hits hits = hits_none;
+				unsigned interest() const {
+					return 0;
+				}
+				takes_hits takes() const {
+					return hits_none;
 				}
 		};
 
-		template <typename _text>
-		class text<text_traits, _text, nothing, nothing> : public text_text<text_traits, _text> {
-		public:
-			using text_text<text_traits, _text>::text_text;
-		};
-
-
-		template <typename _text>
-		class text<baseless_text_traits, _text, nothing, nothing> : public text_text<baseless_text_traits, _text> {
+		// the text graphics has neither fonts nor colors, so any traits with
+		// nothing fonts and colors get the text graphics' texts
+		template <typename _traits, typename _text>
+		class text<_traits, _text, nothing, nothing> : public text_text<_traits, _text> {
 		public:
-			using text_text<baseless_text_traits, _text>::text_text;
+			using text_text<_traits, _text>::text_text;
 		};
 
 	}
@@ -7,8 +7,8 @@
 #include "toys.h"
 
 namespace toys {
-	int system::exit_value_ = 0;
-	bool system::exiting_ = false;
+	std::atomic<int> system::exit_value_(0);
+	std::atomic<bool> system::exiting_(false);
 }
 
 
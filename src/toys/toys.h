@@ -10,6 +10,14 @@
 
 #include <memory>
 #include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <cstddef>
+#include <new>
+#include <tuple>
+#include <algorithm>
+#include <atomic>
+#include <vector>
 
 namespace toys {
 
@@ -41,6 +49,12 @@ namespace toys {
 			vec operator+(const vec& s) const {
 				return vec(x_+s.x_, y_+s.y_, z_+s.z_);
 			}
+			bool operator==(const vec& s) const {
+				return x_ == s.x_ && y_ == s.y_ && z_ == s.z_;
+			}
+			bool operator!=(const vec& s) const {
+				return !(*this == s);
+			}
 			vec operator() (const vec& p) const {
 				return *this;
 			}
@@ -144,12 +158,57 @@ namespace toys {
 		}
 	};
 
+	// clips the drawing to the rectangle of size at the current translation
+	// until the sentry goes out of scope. the nested clips intersect.
+	template <typename _t>
+	struct clip_sentry {
+	private:
+		_t& g_;
+	public:
+		clip_sentry(_t& g, const vec& size) : g_(g) {
+			g.push_clip(size);
+		}
+		~clip_sentry() {
+			g_.pop_clip();
+		}
+	};
+
+	// moves the translation from place to place and undoes it when done. this
+	// is used by containers, which would otherwise need a sentry per child
+	template <typename _t>
+	struct translation_cursor {
+	private:
+		_t& g_;
+		vec at_;
+	public:
+		translation_cursor(_t& g) : g_(g), at_() {}
+		void move(const vec& at) {
+			g_.translate(at - at_);
+			at_ = at;
+		}
+		_t& target() {
+			return g_;
+		}
+		~translation_cursor() {
+			g_.translate(-at_);
+		}
+	};
+
+	// the event classes have bits in the event masks. an event's mask has the
+	// bits of its class and its base classes, while the event classes without
+	// a bit of their own have all the bits, so they reach every toy.
+	const unsigned all_events = ~0u;
+	const unsigned ievent_bit = 1;
+	const unsigned pointevent_bit = 2;
+	const unsigned click_bit = 4;
+
 	class ievent {
 		public:
 			typedef translation_sentry<ievent> translation_sentry_type;
 			virtual ~ievent() {}
 			virtual void translate(const vec& xy) = 0;
 			virtual bool hit(const vec& xy) const { return true; }
+			virtual unsigned event_mask() const { return all_events; }
 			translation_sentry_type translation(const vec& p) {
 				return translation_sentry_type(*this, p);
 			};
@@ -168,20 +227,77 @@ namespace toys {
 			return xy_.x() >= 0 && xy_.y() >= 0
 				&& r.x()-xy_.x() >= 0 && r.y()-xy_.y() >= 0;
 		}
+		unsigned event_mask() const {
+			return ievent_bit | pointevent_bit;
+		}
 	};
 
 	class click : public pointevent {
 		public:
 			click(const vec& xy) : pointevent(xy) {}
+			unsigned event_mask() const {
+				return ievent_bit | pointevent_bit | click_bit;
+			}
+	};
+
+	// the bit of the event class, which an on<_event> handler takes
+	template <typename _event>
+	struct event_bit {
+		static const unsigned value = all_events;
+	};
+	template <>
+	struct event_bit<ievent> {
+		static const unsigned value = ievent_bit;
+	};
+	template <>
+	struct event_bit<pointevent> {
+		static const unsigned value = pointevent_bit;
+	};
+	template <>
+	struct event_bit<click> {
+		static const unsigned value = click_bit;
 	};
 
 	class nothing {};
 
+	// tracing policy, which records nothing. the traits pick the tracing policy
+	// with a trace_type typedef and the traits without one get this policy, so
+	// the trace scopes in the toys compile to nothing.
+	struct null_trace {
+		struct scope {
+			scope(const char* ) {}
+		};
+	};
+
+	template <typename _t>
+	struct voider {
+		typedef void type;
+	};
+
+	template <typename _traits, typename = void>
+	struct trace_of {
+		typedef null_trace type;
+	};
+
+	template <typename _traits>
+	struct trace_of<_traits, typename voider<typename _traits::trace_type>::type> {
+		typedef typename _traits::trace_type type;
+	};
+
+	// scoped trace event around a size, draw or recv call of a toy
+	template <typename _traits>
+	using trace_scope = typename trace_of<_traits>::type::scope;
+
 	namespace gen {
 		// let's put the generics here.
 		// they are not meant to be used by user directly, so they
 	    // can be hidden in separate namespace
 
+		// what a toy's recv returns for the events, that no handler in its
+		// subtree takes: never true, the hit test of the size it gets, or
+		// something that depends on the subtree's shape
+		enum takes_hits { hits_none, hits_size, hits_shape };
+
 		// the abstract toy interface. this is mainly mean to be used
 	    // with heap allocation & reference semantics. this abstract
 	    // interface is meant to be used with bigger UI widgets and not with
@@ -195,6 +311,16 @@ namespace toys {
 				virtual vec size(const vec& size) const { return size; };
 				virtual void draw(const vec& size, graphics_type& i) const = 0;
 				virtual bool recv(const vec& size, ievent& e) { return false; }
+				// whether drawing with the size covers the whole rectangle of the size
+				virtual bool opaque(const vec& size) const { return false; }
+				// the events the toy's subtree may handle, as a mask of event bits.
+				// the combinators answer the other events by the toy's hits
+				// without visiting the toy, unless the hits depend on its shape.
+				static const unsigned interest_mask = all_events;
+				static const takes_hits hits = hits_shape;
+				virtual unsigned interest() const { return all_events; }
+				// the hits of the toy's subtree in run time
+				virtual takes_hits takes() const { return hits_shape; }
 		};
 
 		// base class for static toys that is mean to be used within templates
@@ -204,7 +330,118 @@ namespace toys {
 		struct stoy {
 			vec size(const vec& size) const { return size; };
 			bool recv(const vec& size, ievent& e) { return false; }
+			bool opaque(const vec& size) const { return false; }
+			static const unsigned interest_mask = all_events;
+			static const takes_hits hits = hits_shape;
+			unsigned interest() const { return all_events; }
+			takes_hits takes() const { return hits_shape; }
+		};
+
+		// the toy type behind a toy reference
+		template <typename _ref>
+		struct referred {
+			typedef typename std::decay<decltype(*std::declval<_ref&>().operator->())>::type type;
+		};
+		template <typename _t>
+		struct referred<_t*> {
+			typedef _t type;
+		};
+
+		// the static interest of the toys behind the reference. the toys
+		// without the interest_mask, like the type erased handles, may take
+		// any events.
+		template <typename _t, typename = void>
+		struct static_interest {
+			static const unsigned value = all_events;
+		};
+		template <typename _t>
+		struct static_interest<_t, typename voider<decltype(_t::interest_mask)>::type> {
+			static const unsigned value = _t::interest_mask;
 		};
+		template <typename _ref>
+		struct interest_of {
+			static const unsigned value = static_interest<typename referred<_ref>::type>::value;
+		};
+
+		// the hits of the toys behind the reference, which depend on the
+		// shape for the toys without the hits
+		template <typename _t, typename = void>
+		struct static_hits {
+			static const takes_hits value = hits_shape;
+		};
+		template <typename _t>
+		struct static_hits<_t, typename voider<decltype(_t::hits)>::type> {
+			static const takes_hits value = _t::hits;
+		};
+		template <typename _ref>
+		struct hits_of {
+			static const takes_hits value = static_hits<typename referred<_ref>::type>::value;
+		};
+
+		// the hits of a combinator, whose answer isn't just its size's hit
+		// test, when some child takes hits
+		constexpr takes_hits moved_hits() {
+			return hits_none;
+		}
+		template <typename... _hits>
+		constexpr takes_hits moved_hits(takes_hits h, _hits... hs) {
+			return h == hits_none ? moved_hits(hs...) : hits_shape;
+		}
+
+		constexpr unsigned or_masks() {
+			return 0;
+		}
+		template <typename... _masks>
+		constexpr unsigned or_masks(unsigned m, _masks... ms) {
+			return m | or_masks(ms...);
+		}
+
+		// the interest and the hits of the toy behind the reference in run
+		// time. the value toys answer in compile time, while the type erased
+		// toys, like the itoys, ask their subtree.
+		template <typename _ref>
+		inline unsigned interest_in(const _ref& r) {
+			return interest_of<_ref>::value ? interest_of<_ref>::value & r->interest() : 0;
+		}
+		template <typename _ref>
+		inline takes_hits hits_in(const _ref& r) {
+			return hits_of<_ref>::value == hits_shape ? r->takes() : hits_of<_ref>::value;
+		}
+
+		// whether a handler behind the reference may take the event. the
+		// subtrees of value toys without handlers for the event are ruled
+		// out in compile time, while the itoys tell their interest in run time.
+		template <typename _ref>
+		inline bool wants(const _ref& r, const ievent& e) {
+			if (!interest_of<_ref>::value) return false;
+			unsigned m = e.event_mask();
+			return (interest_of<_ref>::value & m) && (r->interest() & m);
+		}
+
+		// whether the toy behind the reference surely doesn't take the event,
+		// so that the combinators can skip the child's layout too
+		template <typename _ref>
+		inline bool ignores(const _ref& r, const ievent& e) {
+			return hits_in(r) == hits_none && !wants(r, e);
+		}
+
+		// passes the event to the toy behind the reference. the toys without
+		// handlers for the event answer by their hits without the visit, so
+		// the result is the same as the toy's recv. the hits are asked first,
+		// as the toys with the shaped hits get the visit anyway.
+		template <typename _ref>
+		inline bool deliver(_ref& r, const vec& size, ievent& e) {
+			takes_hits h = hits_in(r);
+			if (h != hits_shape && !wants(r, e)) {
+				return h == hits_size && e.hit(size);
+			}
+			return r->recv(size, e);
+		}
+
+		// whether the rectangle of size a covers the rectangle of size b
+		inline bool covers(const vec& a, const vec& b) {
+			return a.x() >= b.x() && a.y() >= b.y();
+		}
 
 		template <typename _graphics, typename _pixel>
 		void fill_rect(_graphics& g, const vec& size, _pixel p);
@@ -216,10 +453,15 @@ namespace toys {
 		private:
 			_toyr t_;
 		public:
-			wrap(const _toyr& t) : t_(t) {}
-			vec size(const vec& size) const 					{ return t_->size(size); };
-			void draw(const vec& size, graphics_type& i) const  { return t_->draw(size, i); }
-			bool recv(const vec& size, ievent& e) 				{ return t_->recv(size, e); }
+			wrap(_toyr t) : t_(std::move(t)) {}
+			vec size(const vec& size) const 					{ trace_scope<_traits> trace("wrap.size"); return t_->size(size); };
+			void draw(const vec& size, graphics_type& i) const  { trace_scope<_traits> trace("wrap.draw"); return t_->draw(size, i); }
+			bool recv(const vec& size, ievent& e) 				{ trace_scope<_traits> trace("wrap.recv"); return deliver(t_, size, e); }
+			bool opaque(const vec& size) const 					{ return t_->opaque(size); }
+			static const unsigned interest_mask = interest_of<_toyr>::value;
+			static const takes_hits hits = hits_of<_toyr>::value;
+			unsigned interest() const 							{ return interest_in(t_); }
+			takes_hits takes() const 							{ return hits_in(t_); }
 		};
 
 		template <typename _traits, typename _pixel>
@@ -231,11 +473,26 @@ namespace toys {
 				pixel_type p_;
 			public:
 				rect(pixel_type p)
-				: p_(p) {}
+				: p_(std::move(p)) {}
 				void draw(const vec& size, graphics_type& g) const {
+					trace_scope<_traits> trace("rect.draw");
 					fill_rect<graphics_type, typename _traits::pixel_type>(g, size, p_);
 				}
-				bool recv(const vec& size, ievent& e) { return e.hit(size); }
+				bool recv(const vec& size, ievent& e) {
+					trace_scope<_traits> trace("rect.recv");
+					return e.hit(size);
+				}
+				bool opaque(const vec& size) const {
+					return true;
+				}
+				static const unsigned interest_mask = 0;
+				static const takes_hits hits = hits_size;
+				unsigned interest() const {
+					return 0;
+				}
+				takes_hits takes() const {
+					return hits_size;
+				}
 		};
 
 		template <typename _traits, typename _tr, typename _toy_ref>
@@ -246,22 +503,38 @@ namespace toys {
 				_tr tr_;
 				_toy_ref toy_;
 			public:
-				at(const _tr& tr, const _toy_ref& toy)
-				: tr_(tr), toy_(toy) {}
+				at(_tr tr, _toy_ref toy)
+				: tr_(std::move(tr)), toy_(std::move(toy)) {}
 				vec size(const vec& size) const {
+					trace_scope<_traits> trace("at.size");
 					vec at = tr_(size);
 					vec tsz = toy_->size(size - at);
 					return tsz + at;
 				}
 				void draw(const vec& size, graphics_type& g) const {
+					trace_scope<_traits> trace("at.draw");
 					vec at = tr_(size);
 					auto ts = g.translation(at);
-					toy_->draw(size - at, g);
+					if (!g.culled(size - at)) toy_->draw(size - at, g);
 				}
 				bool recv(const vec& size, ievent& e) {
+					trace_scope<_traits> trace("at.recv");
+					if (ignores(toy_, e)) return false;
 					vec at = tr_(size);
 					auto ts = e.translation(at);
-					return toy_->recv(size - at, e);
+					return deliver(toy_, size - at, e);
+				}
+				bool opaque(const vec& size) const {
+					vec at = tr_(size);
+					return at.x() <= 0 && at.y() <= 0 && toy_->opaque(size - at);
+				}
+				static const unsigned interest_mask = interest_of<_toy_ref>::value;
+				static const takes_hits hits = moved_hits(hits_of<_toy_ref>::value);
+				unsigned interest() const {
+					return interest_in(toy_);
+				}
+				takes_hits takes() const {
+					return moved_hits(hits_in(toy_));
 				}
 		};
 
@@ -275,16 +548,32 @@ namespace toys {
 				_tr tr_;
 				_toy_ref toy_;
 			public:
-				sz(const _tr& tr, const _toy_ref& toy)
-				: tr_(tr), toy_(toy) {}
+				sz(_tr tr, _toy_ref toy)
+				: tr_(std::move(tr)), toy_(std::move(toy)) {}
 				vec size(const vec& size) const {
+					trace_scope<_traits> trace("sz.size");
 					return tr_(size);
 				}
 				void draw(const vec& size, graphics_type& g) const {
+					trace_scope<_traits> trace("sz.draw");
 					toy_->draw(tr_(size), g);
 				}
 				bool recv(const vec& size, ievent& e) {
-					return toy_->recv(tr_(size), e);
+					trace_scope<_traits> trace("sz.recv");
+					if (ignores(toy_, e)) return false;
+					return deliver(toy_, tr_(size), e);
+				}
+				bool opaque(const vec& size) const {
+					vec sz = tr_(size);
+					return covers(sz, size) && toy_->opaque(sz);
+				}
+				static const unsigned interest_mask = interest_of<_toy_ref>::value;
+				static const takes_hits hits = moved_hits(hits_of<_toy_ref>::value);
+				unsigned interest() const {
+					return interest_in(toy_);
+				}
+				takes_hits takes() const {
+					return moved_hits(hits_in(toy_));
 				}
 		};
 
@@ -296,21 +585,38 @@ namespace toys {
 				_tr      tr_;
 				_toy_ref toy_;
 			public:
-				lay(const _tr& tr, const _toy_ref& toy) : tr_(tr), toy_(toy) {}
+				lay(_tr tr, _toy_ref toy) : tr_(std::move(tr)), toy_(std::move(toy)) {}
 				vec size(const vec& size) const {
+					trace_scope<_traits> trace("lay.size");
 					return size;
 				}
 				void draw(const vec& size, graphics_type& g) const {
+					trace_scope<_traits> trace("lay.draw");
 					vec sz = toy_->size(size);
 					vec at = tr_(size-sz);
 					auto ts = g.translation(at);
-					toy_->draw(size, g);
+					if (!g.culled(sz)) toy_->draw(size, g);
 				}
 				bool recv(const vec& size, ievent& e) {
+					trace_scope<_traits> trace("lay.recv");
+					if (ignores(toy_, e)) return false;
 					vec sz = toy_->size(size);
 					vec at = tr_(size-sz);
 					auto ts = e.translation(at);
-					return toy_->recv(size, e);
+					return deliver(toy_, size, e);
+				}
+				bool opaque(const vec& size) const {
+					vec sz = toy_->size(size);
+					vec at = tr_(size-sz);
+					return at.x() <= 0 && at.y() <= 0 && covers(at + sz, size) && toy_->opaque(size);
+				}
+				static const unsigned interest_mask = interest_of<_toy_ref>::value;
+				static const takes_hits hits = moved_hits(hits_of<_toy_ref>::value);
+				unsigned interest() const {
+					return interest_in(toy_);
+				}
+				takes_hits takes() const {
+					return moved_hits(hits_in(toy_));
 				}
 		};
 
@@ -322,26 +628,228 @@ namespace toys {
 				_lambda f_;
 				_toy_ref toy_;
 			public:
-				on(const _lambda& f, const _toy_ref& t)
-				: f_(f), toy_(t) {}
+				on(_lambda f, _toy_ref t)
+				: f_(std::move(f)), toy_(std::move(t)) {}
 				vec size(const vec& size) const {
+					trace_scope<_traits> trace("on.size");
 					return toy_->size(size);
 				}
 				void draw(const vec& size, graphics_type& g) const {
+					trace_scope<_traits> trace("on.draw");
 					toy_->draw(size, g);
 				}
 				bool recv(const vec& size, ievent& e) {
+					trace_scope<_traits> trace("on.recv");
 					_event* ce = dynamic_cast<_event*>(&e);
 					if (ce && ce->hit(size)) {
 						f_(*ce);
 						return true;
 					} else {
-						return toy_->recv(size, e);
+						return deliver(toy_, size, e);
+					}
+				}
+				bool opaque(const vec& size) const {
+					return toy_->opaque(size);
+				}
+				static const unsigned interest_mask = event_bit<_event>::value | interest_of<_toy_ref>::value;
+				static const takes_hits hits = hits_of<_toy_ref>::value;
+				unsigned interest() const {
+					return event_bit<_event>::value | interest_in(toy_);
+				}
+				takes_hits takes() const {
+					return hits_in(toy_);
+				}
+		};
+
+
+
+		// clips the child's drawing to the given size
+		template <typename _traits, typename _toy_ref>
+		class clip : public _traits::base_type {
+			public:
+				typedef typename _traits::graphics_type graphics_type;
+			private:
+				_toy_ref toy_;
+			public:
+				clip(_toy_ref toy)
+				: toy_(std::move(toy)) {}
+				vec size(const vec& size) const {
+					trace_scope<_traits> trace("clip.size");
+					return toy_->size(size);
+				}
+				void draw(const vec& size, graphics_type& g) const {
+					trace_scope<_traits> trace("clip.draw");
+					// an empty clip rectangle would disable clipping in some backends
+					if (g.culled(size)) return;
+					auto cs = g.clip(size);
+					toy_->draw(size, g);
+				}
+				bool recv(const vec& size, ievent& e) {
+					trace_scope<_traits> trace("clip.recv");
+					return deliver(toy_, size, e);
+				}
+				bool opaque(const vec& size) const {
+					return toy_->opaque(size);
+				}
+				static const unsigned interest_mask = interest_of<_toy_ref>::value;
+				static const takes_hits hits = hits_of<_toy_ref>::value;
+				unsigned interest() const {
+					return interest_in(toy_);
+				}
+				takes_hits takes() const {
+					return hits_in(toy_);
+				}
+		};
+
+		// marks the values read in its lifetime as dependencies of the stale
+		// flag. the scopes nest, so that a value read in an inner layer is
+		// a dependency of the outer layers too.
+		class read_scope {
+			private:
+				std::shared_ptr<bool> stale_;
+				read_scope* outer_;
+				friend class source;
+				static read_scope*& current() {
+					static thread_local read_scope* s = nullptr;
+					return s;
+				}
+			public:
+				read_scope(std::shared_ptr<bool> stale)
+				: stale_(std::move(stale)), outer_(current()) {
+					current() = this;
+				}
+				read_scope(const read_scope&) = delete;
+				read_scope& operator=(const read_scope&) = delete;
+				~read_scope() {
+					current() = outer_;
+				}
+		};
+
+		// value, which changes between the frames, like an animated property.
+		// the layers, which read the value while they render, become stale,
+		// when the value changes. the other layers keep their renders.
+		class source {
+			private:
+				mutable std::vector<std::weak_ptr<bool>> readers_;
+				static bool same(const std::weak_ptr<bool>& a, const std::shared_ptr<bool>& b) {
+					return !a.owner_before(b) && !b.owner_before(a);
+				}
+			public:
+				// to be called, when the value is read
+				void read() const {
+					for (read_scope* s = read_scope::current(); s; s = s->outer_) {
+						if (std::none_of(readers_.begin(), readers_.end(),
+										 [s](const std::weak_ptr<bool>& r) { return same(r, s->stale_); })) {
+							readers_.push_back(s->stale_);
+						}
 					}
 				}
+				// marks the readers stale. they register again on their next render.
+				void changed() {
+					for (const std::weak_ptr<bool>& r : readers_) {
+						if (std::shared_ptr<bool> stale = r.lock()) *stale = true;
+					}
+					readers_.clear();
+				}
+				size_t readers() const {
+					return readers_.size();
+				}
 		};
 
+		// the drawing of a cached toy in an off-screen layer of the graphics.
+		// the copies of a cached toy share the cache.
+		template <typename _graphics>
+		class layer_cache {
+			public:
+				typedef typename _graphics::layer layer_type;
+			private:
+				layer_type layer_;
+				vec size_;
+				bool valid_;
+				std::shared_ptr<bool> stale_;
+				size_t renders_;
+			public:
+				layer_cache() : layer_(), size_(), valid_(false), stale_(std::make_shared<bool>(false)), renders_(0) {}
+				// the layer gets rendered again on the next draw
+				void invalidate() {
+					valid_ = false;
+				}
+				bool valid(const vec& size) const {
+					return valid_ && !*stale_ && size_ == size;
+				}
+				// the sources read while drawing invalidate the layer, when they change
+				template <typename _draw>
+				void render(_graphics& g, const vec& size, const _draw& draw) {
+					*stale_ = false;
+					{
+						read_scope reads(stale_);
+						g.render_layer(layer_, size, draw);
+					}
+					size_ = size;
+					valid_ = true;
+					renders_++;
+				}
+				const layer_type& layer() const {
+					return layer_;
+				}
+				// number of times the layer has been rendered
+				size_t renders() const {
+					return renders_;
+				}
+		};
 
+		// draws the child once into an off-screen layer and then just blits the
+		// layer, until the size changes or the cache is invalidated. the events
+		// handled by the child invalidate the cache, because they usually change
+		// the child's state.
+		template <typename _traits, typename _toy_ref>
+		class cached : public _traits::base_type {
+			public:
+				typedef typename _traits::graphics_type graphics_type;
+				typedef layer_cache<graphics_type> cache_type;
+			private:
+				std::shared_ptr<cache_type> cache_;
+				_toy_ref toy_;
+			public:
+				cached(std::shared_ptr<cache_type> cache, _toy_ref toy)
+				: cache_(std::move(cache)), toy_(std::move(toy)) {}
+				vec size(const vec& size) const {
+					trace_scope<_traits> trace("cached.size");
+					return toy_->size(size);
+				}
+				void draw(const vec& size, graphics_type& g) const {
+					trace_scope<_traits> trace("cached.draw");
+					if (g.culled(size)) return;
+					if (!cache_->valid(size)) {
+						trace_scope<_traits> trace("cached.render");
+						cache_->render(g, size, [this, &size](graphics_type& lg) {
+							toy_->draw(size, lg);
+						});
+					}
+					g.blit_layer(cache_->layer());
+				}
+				bool recv(const vec& size, ievent& e) {
+					trace_scope<_traits> trace("cached.recv");
+					bool rv = deliver(toy_, size, e);
+					// the plain hits, e.g. on a rectangle, leave the drawing as it was
+					if (rv && wants(toy_, e)) cache_->invalidate();
+					return rv;
+				}
+				bool opaque(const vec& size) const {
+					return toy_->opaque(size);
+				}
+				static const unsigned interest_mask = interest_of<_toy_ref>::value;
+				static const takes_hits hits = hits_of<_toy_ref>::value;
+				unsigned interest() const {
+					return interest_in(toy_);
+				}
+				takes_hits takes() const {
+					return hits_in(toy_);
+				}
+				const std::shared_ptr<cache_type>& cache() const {
+					return cache_;
+				}
+		};
 
 		template <typename _traits, typename _tr, typename _f_ref, typename _s_ref = _f_ref>
 		class split : public _traits::base_type {
@@ -353,8 +861,8 @@ namespace toys {
 				_f_ref first_;
 				_s_ref second_;
 			public:
-				split(size_t d, _tr tr, const _f_ref& first, const _s_ref& second)
-				: dim_(d), split_(tr), first_(first), second_(second) {}
+				split(size_t d, _tr tr, _f_ref first, _s_ref second)
+				: dim_(d), split_(std::move(tr)), first_(std::move(first)), second_(std::move(second)) {}
 				void lay(const vec& sz, vec& fsz, vec& spos, vec& ssz) const {
 					vec z(sz);
 					z[dim_] = split_(sz[dim_]);
@@ -363,25 +871,181 @@ namespace toys {
 					z[dim_] = sz[dim_] - z[dim_];
 					ssz = second_->size(z);
 				}
+				// draws the back layer, except the part, that an opaque front layer
+				// covers. when the front covers whole rows or columns of the back
+				// layer, the back layer gets clipped to the rest of the rows or columns.
+				void draw_back(const vec& fsz, const vec& ssz, graphics_type& g) const {
+					vec from;
+					if (first_->opaque(fsz)) {
+						if (covers(fsz, ssz)) return;
+						if (fsz.x() >= ssz.x()) from[1] = std::max(0, fsz.y());
+						else if (fsz.y() >= ssz.y()) from[0] = std::max(0, fsz.x());
+					}
+					vec open(ssz.x() - from.x(), ssz.y() - from.y(), ssz.z());
+					if (from.x() == 0 && from.y() == 0) {
+						second_->draw(ssz, g);
+					} else {
+						// the clip starts at from, while the back layer is drawn at the origin
+						auto ts = g.translation(from);
+						auto cs = g.clip(open);
+						auto back = g.translation(-from);
+						second_->draw(ssz, g);
+					}
+				}
 				void draw(const vec& sz, graphics_type& g) const {
+					trace_scope<_traits> trace("split.draw");
 					vec fsz, spos, ssz;
 					lay(sz, fsz, spos, ssz);
 					{
 						auto ts = g.translation(spos);
-						second_->draw(ssz, g);
+						if (!g.culled(ssz)) {
+							if (dim_ == 2) draw_back(fsz, ssz, g);
+							else second_->draw(ssz, g);
+						}
+					}
+					if (!g.culled(fsz)) first_->draw(fsz, g);
+				}
+				bool opaque(const vec& sz) const {
+					vec fsz, spos, ssz;
+					lay(sz, fsz, spos, ssz);
+					if (dim_ == 2) {
+						return (covers(fsz, sz) && first_->opaque(fsz))
+							|| (covers(ssz, sz) && second_->opaque(ssz));
 					}
-					first_->draw(fsz, g);
+					vec rest(sz);
+					rest[dim_] = sz[dim_] - spos[dim_];
+					vec first(sz);
+					first[dim_] = spos[dim_];
+					return covers(fsz, first) && first_->opaque(fsz)
+						&& covers(ssz, rest) && second_->opaque(ssz);
 				}
 				bool recv(const vec& sz, ievent& e) {
-					bool rv = false;
+					trace_scope<_traits> trace("split.recv");
+					bool first = !ignores(first_, e), second = !ignores(second_, e);
+					if (!first && !second) return false;
 					vec fsz, spos, ssz;
 					lay(sz, fsz, spos, ssz);
-					if (!(rv = first_->recv(fsz, e))) {
+					bool rv = first && deliver(first_, fsz, e);
+					if (!rv && second) {
 						auto ts = e.translation(spos);
-						rv = second_->recv(ssz, e);
+						rv = deliver(second_, ssz, e);
 					}
 					return rv;
 				}
+				static const unsigned interest_mask = interest_of<_f_ref>::value | interest_of<_s_ref>::value;
+				static const takes_hits hits = moved_hits(hits_of<_f_ref>::value, hits_of<_s_ref>::value);
+				unsigned interest() const {
+					return interest_in(first_) | interest_in(second_);
+				}
+				takes_hits takes() const {
+					return hits_in(first_) != hits_none ? hits_shape : moved_hits(hits_in(second_));
+				}
+		};
+
+		// n-ary split: lays out the children side by side in one dimension, giving
+		// each child an equal share of the space. unlike nested splits, the children
+		// are stored flat in a tuple and laid out in a single pass that only moves
+		// the translation from one child to the next.
+		template <typename _traits, typename... _toy_refs>
+		class line : public _traits::base_type {
+			public:
+				typedef typename _traits::graphics_type graphics_type;
+				static const size_t n = sizeof...(_toy_refs);
+			private:
+				typedef std::make_index_sequence<sizeof...(_toy_refs)> indexes;
+				size_t dim_;
+				std::tuple<_toy_refs...> toys_;
+
+				void share(const vec& sz, size_t i, vec& pos, vec& z) const {
+					int begin = (sz[dim_] * int(i)) / int(n);
+					int end = (sz[dim_] * int(i+1)) / int(n);
+					z = sz;
+					z[dim_] = end - begin;
+					pos = vec();
+					pos[dim_] = begin;
+				}
+				template <size_t _i>
+				void draw_at(const vec& sz, translation_cursor<graphics_type>& c) const {
+					vec pos, z;
+					share(sz, _i, pos, z);
+					c.move(pos);
+					auto& t = std::get<_i>(toys_);
+					vec tz = t->size(z);
+					if (!c.target().culled(tz)) t->draw(tz, c.target());
+				}
+				template <size_t _i>
+				bool recv_at(const vec& sz, translation_cursor<ievent>& c) {
+					auto& t = std::get<_i>(toys_);
+					if (ignores(t, c.target())) return false;
+					vec pos, z;
+					share(sz, _i, pos, z);
+					c.move(pos);
+					return deliver(t, t->size(z), c.target());
+				}
+				// like split, earlier children are drawn on top of the later ones
+				template <size_t... _i>
+				void draw(const vec& sz, graphics_type& g, std::index_sequence<_i...>) const {
+					translation_cursor<graphics_type> c(g);
+					int expand[] = {0, (draw_at<n-1-_i>(sz, c), 0)...};
+					(void)expand;
+				}
+				template <size_t _i>
+				bool opaque_at(const vec& sz) const {
+					vec pos, z;
+					share(sz, _i, pos, z);
+					auto& t = std::get<_i>(toys_);
+					vec tz = t->size(z);
+					return covers(tz, z) && t->opaque(tz);
+				}
+				template <size_t... _i>
+				bool opaque(const vec& sz, std::index_sequence<_i...>) const {
+					bool rv = true;
+					int expand[] = {0, (rv = rv && opaque_at<_i>(sz), 0)...};
+					(void)expand;
+					return rv;
+				}
+				template <size_t... _i>
+				bool recv(const vec& sz, ievent& e, std::index_sequence<_i...>) {
+					translation_cursor<ievent> c(e);
+					bool rv = false;
+					int expand[] = {0, (rv = rv || recv_at<_i>(sz, c), 0)...};
+					(void)expand;
+					return rv;
+				}
+				template <size_t... _i>
+				unsigned interest(std::index_sequence<_i...>) const {
+					return or_masks(interest_in(std::get<_i>(toys_))...);
+				}
+				// stops at the first child, that takes hits
+				template <size_t... _i>
+				takes_hits takes(std::index_sequence<_i...>) const {
+					takes_hits rv = hits_none;
+					int expand[] = {0, (rv = rv != hits_none ? hits_shape : moved_hits(hits_in(std::get<_i>(toys_))), 0)...};
+					(void)expand;
+					return rv;
+				}
+			public:
+				line(size_t d, _toy_refs... toys)
+				: dim_(d), toys_(std::move(toys)...) {}
+				void draw(const vec& sz, graphics_type& g) const {
+					trace_scope<_traits> trace("line.draw");
+					draw(sz, g, indexes());
+				}
+				bool recv(const vec& sz, ievent& e) {
+					trace_scope<_traits> trace("line.recv");
+					return recv(sz, e, indexes());
+				}
+				static const unsigned interest_mask = or_masks(interest_of<_toy_refs>::value...);
+				static const takes_hits hits = moved_hits(hits_of<_toy_refs>::value...);
+				unsigned interest() const {
+					return interest(indexes());
+				}
+				takes_hits takes() const {
+					return takes(indexes());
+				}
+				bool opaque(const vec& sz) const {
+					return opaque(sz, indexes());
+				}
 		};
 
 		template <typename _l, typename _t>
@@ -400,6 +1064,158 @@ namespace toys {
 			}
 		};
 
+		// type erased toy handle with value semantics. unlike owned_itoy and shared_itoy,
+		// the toy is stored inline in the handle as long as it fits in _capacity bytes,
+		// and only bigger toy trees are moved to heap. the calls are dispatched through
+		// a static function table instead of itoy's vtable. the handle behaves like
+		// a toy reference (operator ->), so it can be used as a child in any combinator
+		// and heterogeneous toys can be stored e.g. in vectors without allocations.
+		template <typename _traits, size_t _capacity = 64>
+		class any_toy {
+			public:
+				typedef typename _traits::graphics_type graphics_type;
+			private:
+				struct ops {
+					vec  (*size)(const void* t, const vec& size);
+					void (*draw)(const void* t, const vec& size, graphics_type& g);
+					bool (*recv)(void* t, const vec& size, ievent& e);
+					bool (*opaque)(const void* t, const vec& size);
+					unsigned (*interest)(const void* t);
+					takes_hits (*takes)(const void* t);
+					void (*copy)(const void* t, void* to);
+					void (*move)(void* t, void* to);
+					void (*destroy)(void* t);
+					bool inlined_;
+				};
+
+				typedef typename std::aligned_storage<_capacity, alignof(std::max_align_t)>::type storage_type;
+
+				// the toys, which may throw in the move, go to heap, so that moving
+				// the handle never throws and the vectors move the handles
+				template <typename _toyr>
+				struct fits {
+					static const bool value =
+						sizeof(_toyr) <= _capacity
+					 && alignof(std::max_align_t) % alignof(_toyr) == 0
+					 && std::is_nothrow_move_constructible<_toyr>::value;
+				};
+
+				// inline storage: the toy reference lives in the buffer
+				template <typename _toyr, bool _inline = fits<_toyr>::value>
+				struct holder {
+					static _toyr& get(void* t) 			   { return *static_cast<_toyr*>(t); }
+					static const _toyr& get(const void* t) { return *static_cast<const _toyr*>(t); }
+					template <typename _t>
+					static void make(void* to, _t&& t)     { new (to) _toyr(std::forward<_t>(t)); }
+					static void copy(const void* t, void* to) { new (to) _toyr(get(t)); }
+					static void move(void* t, void* to)    { new (to) _toyr(std::move(get(t))); get(t).~_toyr(); }
+					static void destroy(void* t) 		   { get(t).~_toyr(); }
+				};
+
+				// heap storage: the buffer holds a pointer to the toy reference
+				template <typename _toyr>
+				struct holder<_toyr, false> {
+					static _toyr& get(void* t) 			   { return **static_cast<_toyr**>(t); }
+					static const _toyr& get(const void* t) { return **static_cast<_toyr* const*>(t); }
+					template <typename _t>
+					static void make(void* to, _t&& t)     { *static_cast<_toyr**>(to) = new _toyr(std::forward<_t>(t)); }
+					static void copy(const void* t, void* to) { *static_cast<_toyr**>(to) = new _toyr(get(t)); }
+					static void move(void* t, void* to)    { *static_cast<_toyr**>(to) = *static_cast<_toyr**>(t); }
+					static void destroy(void* t) 		   { delete *static_cast<_toyr**>(t); }
+				};
+
+				template <typename _toyr>
+				struct ops_of {
+					typedef holder<_toyr> h;
+					static vec size(const void* t, const vec& size) 			  { return h::get(t)->size(size); }
+					static void draw(const void* t, const vec& size, graphics_type& g) { h::get(t)->draw(size, g); }
+					static bool recv(void* t, const vec& size, ievent& e) 	  	  { return h::get(t)->recv(size, e); }
+					static bool opaque(const void* t, const vec& size) 			  { return h::get(t)->opaque(size); }
+					static unsigned interest(const void* t) 					  { return interest_in(h::get(t)); }
+					static takes_hits takes(const void* t) 					  { return hits_in(h::get(t)); }
+					static const ops table;
+				};
+
+				// the moved-from and default constructed handles are empty
+				struct empty_ops {
+					static vec size(const void* , const vec& size) 			 	  { return size; }
+					static void draw(const void* , const vec& , graphics_type& )  {}
+					static bool recv(void* , const vec& , ievent& ) 			  { return false; }
+					static bool opaque(const void* , const vec& ) 				  { return false; }
+					static unsigned interest(const void* ) 						  { return 0; }
+					static takes_hits takes(const void* ) 						  { return hits_none; }
+					static void copy(const void* , void* ) 						  {}
+					static void move(void* , void* ) 							  {}
+					static void destroy(void* ) 								  {}
+					static const ops table;
+				};
+
+				const ops* ops_;
+				storage_type buf_;
+
+			public:
+				any_toy() : ops_(&empty_ops::table), buf_() {}
+				template <typename _toyr,
+						  typename = typename std::enable_if<
+						  	  !std::is_same<typename std::decay<_toyr>::type, any_toy>::value>::type>
+				any_toy(_toyr&& t)
+				: ops_(&ops_of<typename std::decay<_toyr>::type>::table), buf_() {
+					holder<typename std::decay<_toyr>::type>::make(&buf_, std::forward<_toyr>(t));
+				}
+				any_toy(const any_toy& t) : ops_(t.ops_), buf_() {
+					ops_->copy(&t.buf_, &buf_);
+				}
+				any_toy(any_toy&& t) noexcept : ops_(t.ops_), buf_() {
+					ops_->move(&t.buf_, &buf_);
+					t.ops_ = &empty_ops::table;
+				}
+				any_toy& operator=(const any_toy& t) {
+					if (this != &t) {
+						any_toy c(t);
+						*this = std::move(c);
+					}
+					return *this;
+				}
+				any_toy& operator=(any_toy&& t) noexcept {
+					if (this != &t) {
+						ops_->destroy(&buf_);
+						ops_ = t.ops_;
+						ops_->move(&t.buf_, &buf_);
+						t.ops_ = &empty_ops::table;
+					}
+					return *this;
+				}
+				~any_toy() {
+					ops_->destroy(&buf_);
+				}
+				bool inlined() const {
+					return ops_->inlined_;
+				}
+				vec size(const vec& size) const 				   { return ops_->size(&buf_, size); }
+				void draw(const vec& size, graphics_type& g) const { ops_->draw(&buf_, size, g); }
+				bool recv(const vec& size, ievent& e) 			   { return ops_->recv(&buf_, size, e); }
+				bool opaque(const vec& size) const 				   { return ops_->opaque(&buf_, size); }
+				unsigned interest() const 						   { return ops_->interest(&buf_); }
+				takes_hits takes() const 						   { return ops_->takes(&buf_); }
+				const any_toy* operator->() const {
+					return this;
+				}
+				any_toy* operator->() {
+					return this;
+				}
+		};
+
+		template <typename _traits, size_t _capacity>
+		template <typename _toyr>
+		const typename any_toy<_traits, _capacity>::ops any_toy<_traits, _capacity>::ops_of<_toyr>::table = {
+			&size, &draw, &recv, &opaque, &interest, &takes, &h::copy, &h::move, &h::destroy, fits<_toyr>::value
+		};
+
+		template <typename _traits, size_t _capacity>
+		const typename any_toy<_traits, _capacity>::ops any_toy<_traits, _capacity>::empty_ops::table = {
+			&size, &draw, &recv, &opaque, &interest, &takes, &copy, &move, &destroy, true
+		};
+
 	}
 
 	// value semantics
@@ -411,8 +1227,17 @@ namespace toys {
 			T v_;
 		public:
 			val(const T& v) : v_(v) {}
+			val(T&& v) : v_(std::move(v)) {}
 			val(const val<T>& v) : v_(v.v_) {}
-			val(const val<T>&& v) : v_(std::move(v.v_)) {}
+			val(val<T>&& v) noexcept(std::is_nothrow_move_constructible<T>::value) : v_(std::move(v.v_)) {}
+			val<T>& operator=(const val<T>& v) {
+				v_ = v.v_;
+				return *this;
+			}
+			val<T>& operator=(val<T>&& v) noexcept(std::is_nothrow_move_assignable<T>::value) {
+				v_ = std::move(v.v_);
+				return *this;
+			}
 			const T* operator->() const {
 				return &v_;
 			}
@@ -435,8 +1260,8 @@ namespace toys {
 
 
 	template <typename T>
-	val<T> to_val(const T& t) {
-		return val<T>(t);
+	val<typename std::decay<T>::type> to_val(T&& t) {
+		return val<typename std::decay<T>::type>(std::forward<T>(t));
 	}
 
 	template <typename _l>
@@ -448,90 +1273,130 @@ namespace toys {
 
 	struct value_copy {
 		template <typename T>
-		static val<T> ref(const T& t) {
-			return to_val<T>(t);
+		static val<typename std::decay<T>::type> ref(T&& t) {
+			return to_val(std::forward<T>(t));
 		}
 	};
 
+	// the exit request may come from any thread. the exit value is published
+	// before the flag, so a reader seeing exiting() sees the value too.
 	class system {
 	private:
-		static int exit_value_;
-		static bool exiting_;
+		static std::atomic<int> exit_value_;
+		static std::atomic<bool> exiting_;
 	public:
 		static void init() {
-			exit_value_ = 0;
-			exiting_ = false;
+			exit_value_.store(0, std::memory_order_relaxed);
+			exiting_.store(false, std::memory_order_release);
 		}
 		static bool exiting() {
-			return exiting_;
+			return exiting_.load(std::memory_order_acquire);
 		}
 		static int exit_value() {
-			return exit_value_;
+			return exit_value_.load(std::memory_order_relaxed);
 		}
 		static void exit(int exit_value) {
-			exit_value_ = exit_value;
-			exiting_ = true;
+			exit_value_.store(exit_value, std::memory_order_relaxed);
+			exiting_.store(true, std::memory_order_release);
 		}
 	};
 
+	// the builders take the children as forwarding references and move the
+	// temporaries into the parent, so building a tree constructs each leaf once
+	// instead of copying it once per tree level
 	template <typename _traits, typename _mem>
 	class box {
+		private:
+			template <typename _t>
+			using bare = typename std::decay<_t>::type;
 		public:
 			template <typename _t>
-			static auto ref(const _t& t) {
-				return _mem::ref(t);
+			static auto ref(_t&& t) {
+				return _mem::ref(std::forward<_t>(t));
 			}
 			template <typename _tr, typename _toy_ref>
-			static auto sz(const _tr& tr, const _toy_ref& ref) {
-				return _mem::ref(gen::sz<_traits, _tr, _toy_ref>(tr, ref));
+			static auto sz(_tr&& tr, _toy_ref&& ref) {
+				return _mem::ref(gen::sz<_traits, bare<_tr>, bare<_toy_ref>>(
+					std::forward<_tr>(tr), std::forward<_toy_ref>(ref)));
 			}
 			template <typename _lambda, typename _toy_ref>
-			static auto on_click(const _lambda& l, const _toy_ref& ref) {
-				return _mem::ref(gen::on<_traits, click, _lambda, _toy_ref>(l, ref));
+			static auto on_click(_lambda&& l, _toy_ref&& ref) {
+				return _mem::ref(gen::on<_traits, click, bare<_lambda>, bare<_toy_ref>>(
+					std::forward<_lambda>(l), std::forward<_toy_ref>(ref)));
 			}
 			template <typename _xy, typename _toy_ref>
-			static auto at(_xy xy, const _toy_ref& ref) {
-				return _mem::ref(gen::at<_traits, _xy, _toy_ref>(xy, ref));
+			static auto at(_xy xy, _toy_ref&& ref) {
+				return _mem::ref(gen::at<_traits, _xy, bare<_toy_ref>>(
+					std::move(xy), std::forward<_toy_ref>(ref)));
 			}
 			template <typename _xy, typename _toy_ref>
-			static auto lay(_xy xy, const _toy_ref& ref) {
-				return _mem::ref(gen::lay<_traits, _xy, _toy_ref>(xy, ref));
+			static auto lay(_xy xy, _toy_ref&& ref) {
+				return _mem::ref(gen::lay<_traits, _xy, bare<_toy_ref>>(
+					std::move(xy), std::forward<_toy_ref>(ref)));
+			}
+			template <typename _toy_ref>
+			static auto clip(_toy_ref&& ref) {
+				return _mem::ref(gen::clip<_traits, bare<_toy_ref>>(std::forward<_toy_ref>(ref)));
+			}
+			typedef gen::layer_cache<typename _traits::graphics_type> cache_type;
+			template <typename _toy_ref>
+			static auto cached(std::shared_ptr<cache_type> cache, _toy_ref&& ref) {
+				return _mem::ref(gen::cached<_traits, bare<_toy_ref>>(
+					std::move(cache), std::forward<_toy_ref>(ref)));
+			}
+			template <typename _toy_ref>
+			static auto cached(_toy_ref&& ref) {
+				return cached(std::make_shared<cache_type>(), std::forward<_toy_ref>(ref));
 			}
 			template <typename _pixel>
 			static auto rc(_pixel pixel) {
-				return ref(gen::rect<_traits, _pixel>(pixel));
+				return ref(gen::rect<_traits, _pixel>(std::move(pixel)));
 			}
 			template <typename _text, typename _font, typename _color>
 			static auto tx(_text text, const _font& font, _color color) {
-				return ref(gen::text<_traits, _text, _font, _color>(text, font, color));
+				return ref(gen::text<_traits, _text, _font, _color>(std::move(text), font, std::move(color)));
 			}
 			template <typename _font, typename _color>
 			static auto tx(const char* text, const _font& font, _color color) {
-				return ref(gen::text<_traits, std::string, _font, _color>(text, font, color));
+				return ref(gen::text<_traits, std::string, _font, _color>(text, font, std::move(color)));
 			}
 			template <typename _f_ref, typename _s_ref>
-			static auto lr(int sp, const _f_ref& f, const _s_ref& s) {
-				return ref(gen::split<_traits, aval, _f_ref, _s_ref>(0, aval(sp), f, s));
+			static auto lr(int sp, _f_ref&& f, _s_ref&& s) {
+				return ref(gen::split<_traits, aval, bare<_f_ref>, bare<_s_ref>>(
+					0, aval(sp), std::forward<_f_ref>(f), std::forward<_s_ref>(s)));
 			}
 			template <typename _f_ref, typename _s_ref>
-			static auto lr(double sp, const _f_ref& f, const _s_ref& s) {
-				return ref(gen::split<_traits, rval, _f_ref, _s_ref>(0, rval(sp), f, s));
+			static auto lr(double sp, _f_ref&& f, _s_ref&& s) {
+				return ref(gen::split<_traits, rval, bare<_f_ref>, bare<_s_ref>>(
+					0, rval(sp), std::forward<_f_ref>(f), std::forward<_s_ref>(s)));
 			}
 			template <typename _f_ref, typename _s_ref>
-			static auto ud(int sp, const _f_ref& f, const _s_ref& s) {
-				return ref(gen::split<_traits, aval, _f_ref, _s_ref>(1, aval(sp), f, s));
+			static auto ud(int sp, _f_ref&& f, _s_ref&& s) {
+				return ref(gen::split<_traits, aval, bare<_f_ref>, bare<_s_ref>>(
+					1, aval(sp), std::forward<_f_ref>(f), std::forward<_s_ref>(s)));
 			}
 			template <typename _f_ref, typename _s_ref>
-			static auto ud(double sp, const _f_ref& f, const _s_ref& s) {
-				return ref(gen::split<_traits, rval, _f_ref, _s_ref>(1, rval(sp), f, s));
+			static auto ud(double sp, _f_ref&& f, _s_ref&& s) {
+				return ref(gen::split<_traits, rval, bare<_f_ref>, bare<_s_ref>>(
+					1, rval(sp), std::forward<_f_ref>(f), std::forward<_s_ref>(s)));
 			}
 			template <typename _f_ref, typename _s_ref>
-			static auto fb(int sp, const _f_ref& f, const _s_ref& s) {
-				return ref(gen::split<_traits, aval, _f_ref, _s_ref>(2, aval(sp), f, s));
+			static auto fb(int sp, _f_ref&& f, _s_ref&& s) {
+				return ref(gen::split<_traits, aval, bare<_f_ref>, bare<_s_ref>>(
+					2, aval(sp), std::forward<_f_ref>(f), std::forward<_s_ref>(s)));
 			}
 			template <typename _f_ref, typename _s_ref>
-			static auto fb(const _f_ref& f, const _s_ref& s) {
-				return ref(gen::split<_traits, rval, _f_ref, _s_ref>(2, rval(0.5), f, s));
+			static auto fb(_f_ref&& f, _s_ref&& s) {
+				return ref(gen::split<_traits, rval, bare<_f_ref>, bare<_s_ref>>(
+					2, rval(0.5), std::forward<_f_ref>(f), std::forward<_s_ref>(s)));
+			}
+			template <typename... _toy_refs>
+			static auto row(_toy_refs&&... refs) {
+				return ref(gen::line<_traits, bare<_toy_refs>...>(0, std::forward<_toy_refs>(refs)...));
+			}
+			template <typename... _toy_refs>
+			static auto col(_toy_refs&&... refs) {
+				return ref(gen::line<_traits, bare<_toy_refs>...>(1, std::forward<_toy_refs>(refs)...));
 			}
 
 	};
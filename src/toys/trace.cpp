@@ -0,0 +1,101 @@
+/*
+ * trace.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arau
+ */
+
+#include "toys/trace.h"
+#include <mutex>
+#include <ostream>
+#include <iomanip>
+#include <algorithm>
+
+namespace toys {
+
+	namespace {
+
+		// the rings outlive their threads, so the events of finished
+		// threads can still be written out
+		struct trace_rings {
+			std::mutex lock_;
+			std::vector<std::unique_ptr<trace_ring>> rings_;
+			static trace_rings& instance() {
+				static trace_rings r;
+				return r;
+			}
+			trace_ring* add() {
+				std::lock_guard<std::mutex> l(lock_);
+				rings_.emplace_back(new trace_ring(int(rings_.size()) + 1));
+				return rings_.back().get();
+			}
+		};
+
+		void write_us(std::ostream& o, uint64_t ns) {
+			o<<(ns / 1000)<<"."<<std::setw(3)<<std::setfill('0')<<(ns % 1000)<<std::setfill(' ');
+		}
+
+	}
+
+	trace_ring::trace_ring(int tid)
+	: events_(new trace_event[capacity]), head_(0), tail_(0), tid_(tid) {}
+
+	trace_ring& trace_ring::local() {
+		static thread_local trace_ring* ring = 0;
+		if (!ring) ring = trace_rings::instance().add();
+		return *ring;
+	}
+
+	size_t trace_ring::dropped() const {
+		uint64_t h = head_.load(std::memory_order_acquire);
+		uint64_t t = tail_.load(std::memory_order_relaxed);
+		return h - t > capacity ? h - t - capacity : 0;
+	}
+
+	void trace_ring::clear() {
+		tail_.store(head_.load(std::memory_order_acquire), std::memory_order_relaxed);
+	}
+
+	// the snapshot is consistent as long as the owning thread doesn't
+	// wrap around the ring while it's being copied
+	std::vector<trace_event> trace_ring::events() const {
+		uint64_t h = head_.load(std::memory_order_acquire);
+		uint64_t t = std::max(tail_.load(std::memory_order_relaxed),
+							  h > capacity ? h - capacity : 0);
+		std::vector<trace_event> rv;
+		rv.reserve(h - t);
+		for (uint64_t i = t; i < h; ++i) {
+			rv.push_back(events_[i & (capacity - 1)]);
+		}
+		return rv;
+	}
+
+	void chrome_trace::write(std::ostream& o) {
+		trace_rings& r = trace_rings::instance();
+		std::lock_guard<std::mutex> l(r.lock_);
+		o<<"{\"traceEvents\":[";
+		bool first = true;
+		for (auto& ring : r.rings_) {
+			// the names are literals from the toys, so they need no escaping
+			for (const trace_event& e : ring->events()) {
+				o<<(first ? "\n" : ",\n");
+				o<<"{\"name\":\""<<e.name_<<"\",\"cat\":\"toys\",\"ph\":\"X\",\"ts\":";
+				write_us(o, e.begin_);
+				o<<",\"dur\":";
+				write_us(o, e.end_ - e.begin_);
+				o<<",\"pid\":1,\"tid\":"<<ring->tid()<<"}";
+				first = false;
+			}
+		}
+		o<<"\n],\"displayTimeUnit\":\"ns\"}\n";
+	}
+
+	void chrome_trace::clear() {
+		trace_rings& r = trace_rings::instance();
+		std::lock_guard<std::mutex> l(r.lock_);
+		for (auto& ring : r.rings_) {
+			ring->clear();
+		}
+	}
+
+}
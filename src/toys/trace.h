@@ -0,0 +1,91 @@
+/*
+ * trace.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arau
+ */
+
+#ifndef TOYS_TRACE_H
+#define TOYS_TRACE_H
+
+#include "toys/toys.h"
+#include <atomic>
+#include <chrono>
+#include <iosfwd>
+#include <memory>
+#include <vector>
+#include <stdint.h>
+
+namespace toys {
+
+	// complete event: the toy call name with its begin and end times in ns
+	struct trace_event {
+		const char* name_;
+		uint64_t begin_;
+		uint64_t end_;
+	};
+
+	// per thread ring of the latest trace events. only the owning thread
+	// writes in the ring, so pushing an event is a plain store followed by
+	// a release of the head without locks. when the ring is full, the oldest
+	// events get overwritten.
+	class trace_ring {
+		public:
+			static const size_t capacity = 1 << 16;
+		private:
+			std::unique_ptr<trace_event[]> events_;
+			std::atomic<uint64_t> head_;
+			std::atomic<uint64_t> tail_;
+			int tid_;
+		public:
+			trace_ring(int tid);
+			// the ring of the calling thread
+			static trace_ring& local();
+			inline void push(const char* name, uint64_t begin, uint64_t end) {
+				uint64_t h = head_.load(std::memory_order_relaxed);
+				trace_event& e = events_[h & (capacity - 1)];
+				e.name_ = name;
+				e.begin_ = begin;
+				e.end_ = end;
+				head_.store(h + 1, std::memory_order_release);
+			}
+			int tid() const {
+				return tid_;
+			}
+			// events, which were overwritten since the last clear
+			size_t dropped() const;
+			void clear();
+			// snapshot of the events in the order they were completed
+			std::vector<trace_event> events() const;
+	};
+
+	// tracing policy, which records each toy call as a complete event in the
+	// calling thread's ring. enable it by adding typedef chrome_trace trace_type
+	// to the traits, and write the rings out with write() for chrome://tracing
+	// or any other viewer of the chrome trace json format.
+	struct chrome_trace {
+		static inline uint64_t now() {
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+		class scope {
+			private:
+				const char* name_;
+				uint64_t begin_;
+			public:
+				scope(const char* name) : name_(name), begin_(now()) {}
+				scope(const scope&) = delete;
+				scope& operator=(const scope&) = delete;
+				~scope() {
+					trace_ring::local().push(name_, begin_, now());
+				}
+		};
+		// writes the events of all threads as chrome trace json
+		static void write(std::ostream& o);
+		// drops the recorded events of all threads
+		static void clear();
+	};
+
+}
+
+#endif
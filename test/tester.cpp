@@ -11,11 +11,117 @@ char* gets(char*);
 
 #include "tester.h"
 #include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <sys/stat.h>
+#include <sys/wait.h>
+#include <math.h>
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
 
 //checkl_t checkl;
 using namespace std;
 
+#ifdef __linux__
+
+static int open_counter(uint64_t config, int group) {
+	perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.config = config;
+	attr.disabled = group == -1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID;
+	return syscall(__NR_perf_event_open, &attr, 0, -1, group, 0);
+}
+
+perf_counters::perf_counters() : fds_(), ids_(), values_() {
+	static const uint64_t configs[counter_count] = {
+		PERF_COUNT_HW_CPU_CYCLES,
+		PERF_COUNT_HW_INSTRUCTIONS,
+		PERF_COUNT_HW_CACHE_MISSES,
+		PERF_COUNT_HW_BRANCH_MISSES
+	};
+	for (int i = 0; i < counter_count; ++i) {
+		fds_[i] = open_counter(configs[i], i == 0 ? -1 : fds_[0]);
+		if (i == 0 && fds_[0] < 0) {
+			for (int j = 1; j < counter_count; ++j) fds_[j] = -1;
+			break;
+		}
+		if (fds_[i] >= 0) ioctl(fds_[i], PERF_EVENT_IOC_ID, &ids_[i]);
+	}
+}
+
+perf_counters::~perf_counters() {
+	for (int i = 0; i < counter_count; ++i) {
+		if (fds_[i] >= 0) close(fds_[i]);
+	}
+}
+
+void perf_counters::start() {
+	if (!available()) return;
+	ioctl(fds_[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+	ioctl(fds_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+void perf_counters::stop() {
+	if (!available()) return;
+	ioctl(fds_[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+	// group read format: { nr, { value, id } [nr] }
+	uint64_t buf[1 + 2 * counter_count];
+	if (read(fds_[0], buf, sizeof(buf)) <= 0) return;
+	for (uint64_t i = 0; i < buf[0] && i < counter_count; ++i) {
+		for (int c = 0; c < counter_count; ++c) {
+			if (fds_[c] >= 0 && ids_[c] == buf[2 + 2 * i]) values_[c] = buf[1 + 2 * i];
+		}
+	}
+}
+
+#else
+
+perf_counters::perf_counters() : fds_(), ids_(), values_() {
+	for (int i = 0; i < counter_count; ++i) fds_[i] = -1;
+}
+perf_counters::~perf_counters() {}
+void perf_counters::start() {}
+void perf_counters::stop() {}
+
+#endif
+
+bool perf_counters::available() const {
+	return fds_[0] >= 0;
+}
+
+bool perf_counters::available(counter c) const {
+	return fds_[c] >= 0;
+}
+
+uint64_t perf_counters::value(counter c) const {
+	return values_[c];
+}
+
+const char* perf_counters::name(counter c) {
+	static const char* names[counter_count] = {
+		"cycles", "instructions", "cache-misses", "branch-misses"
+	};
+	return names[c];
+}
+
+void perf_counters::record(test_tool& t, const std::set<std::string>& tags, double calls) const {
+	for (int c = 0; c < counter_count; ++c) {
+		if (available(counter(c))) {
+			t.record(tags + (std::string("counter:") + name(counter(c))), values_[c] / calls);
+		}
+	}
+}
+
 report_output::report_output(test_tool& tool, linemod_t mod)
 : tool_(tool), mod_(mod) {
 	if (tool_.line_.str().size()) {
@@ -41,6 +147,7 @@ test_tool::test_tool(const string& test, bool& ok, bool verbose)
 	linenumber_(),
 	verbose_(verbose),
 	cleanline_(),
+	recfrozen_(),
 	fail_(),
 	ok_(ok),
 	time_(),
@@ -53,10 +160,10 @@ test_tool::test_tool(const string& test, bool& ok, bool verbose)
 	}
 	if (verbose_) { cout<<endl<<endl; cleanline_ = true; }
 	std::ifstream rec(recexpfile_);
+	recfrozen_ = bool(rec);
 	if (rec) {
-		while (rec) {
-			int keys = 0;
-			rec>>keys;
+		int keys = 0;
+		while (rec>>keys) {
 			record_entry e;
 			for (int i = 0; i < keys; ++i) {
 				std::string key;
@@ -82,6 +189,12 @@ test_tool::~test_tool() {
 	if (frozen_ && !fail_) {
 		cout<<"ok. "<<endl;
 		remove(outfile_.c_str());
+		// the first passing run sets the baseline for the regression checks
+		if (records_.size() > 0 && !recfrozen_) {
+			if (!rename(recoutfile_.c_str(), recexpfile_.c_str())) {
+				cout<<"records frozen."<<endl;
+			}
+		}
 	} else {
 		if (frozen_) cout<<"failed. ";
 		while (true) {
@@ -128,6 +241,11 @@ test_tool::~test_tool() {
 test_tool& test_tool::operator<<(linemod_t mod) {
 	string l = line_.str();
 	line_.str("");
+	if (mod == notel) {
+		if (!cleanline_) { cout<<endl; cleanline_ = true; };
+		cout<<"[----] N "<<l<<endl;
+		return *this;
+	}
 	linenumber_++;
 	out_ << l << endl;
 	string e;
@@ -176,8 +294,119 @@ void test_tool::record(const std::set<std::string>& tags, double value) {
 	records_.back().first.insert("run:out");
 }
 
-test_runner::test_runner(const char* testname)
-: testname_(testname), tests_() {}
+void test_tool::record(const std::set<std::string>& tags, const sample_stats& stats) {
+	record(tags + "stat:min", stats.min_);
+	record(tags + "stat:max", stats.max_);
+	record(tags + "stat:mean", stats.mean_);
+	record(tags + "stat:median", stats.median_);
+	record(tags + "stat:p10", stats.p10_);
+	record(tags + "stat:p90", stats.p90_);
+	record(tags + "stat:stddev", stats.stddev_);
+}
+
+// the record tags as a table label
+static std::string record_label(const std::set<std::string>& tags) {
+	std::string rv;
+	for (const std::string& t : tags) {
+		if (rv.size()) rv += " ";
+		rv += t;
+	}
+	return rv;
+}
+
+int test_tool::check_regressions(const regression_options& o) {
+	std::map<std::set<std::string>, double> exp, out;
+	for (const record_entry& e : records_) {
+		std::set<std::string> key(e.first);
+		if (key.erase("run:exp")) {
+			exp[key] = e.second;
+		} else if (key.erase("run:out")) {
+			out[key] = e.second;
+		}
+	}
+	// the records without a baseline are listed too, so that the report
+	// has the same lines before and after the baseline gets frozen
+	std::vector<std::set<std::string>> keys;
+	for (auto& r : out) {
+		if (subset(r.first, o.filter_)) {
+			keys.push_back(r.first);
+		}
+	}
+	std::vector<std::string> ylabels;
+	for (auto& k : keys) ylabels.push_back(record_label(k));
+	table t({"exp", "out", "delta%", "noise", "regressed"}, ylabels, "record");
+
+	int regressions = 0;
+	for (size_t i = 0; i < keys.size(); ++i) {
+		const std::set<std::string>& k = keys[i];
+		double v = out[k];
+		if (!exp.count(k)) {
+			t.at(1, i) = v;
+			continue;
+		}
+		double e = exp[k];
+		double delta = o.lower_better_ ? v - e : e - v;
+		// the stddev records, which were recorded together with this statistic
+		std::set<std::string> sdkey;
+		for (const std::string& tag : k) {
+			sdkey.insert(tag.substr(0, 5) == "stat:" ? std::string("stat:stddev") : tag);
+		}
+		double noise = 0;
+		if (sdkey != k && exp.count(sdkey) && out.count(sdkey)) {
+			noise = o.noise_ * sqrt(exp[sdkey]*exp[sdkey] + out[sdkey]*out[sdkey]);
+		}
+		bool regressed = delta > o.threshold_ * fabs(e) && delta > noise;
+		if (regressed) regressions++;
+		t.at(0, i) = e;
+		t.at(1, i) = v;
+		t.at(2, i) = e ? 100 * (v - e) / fabs(e) : 0;
+		t.at(3, i) = noise;
+		t.at(4, i) = regressed;
+	}
+
+	std::ostringstream report;
+	report<<"compared to frozen records (threshold "<<(o.threshold_*100)<<"%, noise "
+		  <<o.noise_<<" stddev):\n\n";
+	t.format(report, 2);
+	report<<"\n"<<regressions<<" regressions.\n";
+	(*this)<<"\n";
+	reported()<<report.str();
+	if (regressions) fail_ = true;
+	return regressions;
+}
+
+sample_stats::sample_stats(std::vector<double> samples, size_t iterations)
+: iterations_(iterations), samples_(samples.size()),
+  min_(), max_(), mean_(), median_(), p10_(), p90_(), stddev_() {
+	if (samples.empty()) return;
+	std::sort(samples.begin(), samples.end());
+	min_ = samples.front();
+	max_ = samples.back();
+	for (double s : samples) mean_ += s;
+	mean_ /= samples.size();
+	for (double s : samples) stddev_ += (s - mean_) * (s - mean_);
+	if (samples.size() > 1) stddev_ = sqrt(stddev_ / (samples.size() - 1));
+	median_ = percentile(samples, 0.5);
+	p10_ = percentile(samples, 0.1);
+	p90_ = percentile(samples, 0.9);
+}
+
+double sample_stats::percentile(const std::vector<double>& sorted, double p) {
+	double at = p * (sorted.size() - 1);
+	size_t i = size_t(at);
+	if (i + 1 >= sorted.size()) return sorted.back();
+	return sorted[i] + (at - i) * (sorted[i+1] - sorted[i]);
+}
+
+std::ostream& operator<<(std::ostream& o, const sample_stats& s) {
+	o<<"median "<<s.median_<<" ns, p10 "<<s.p10_<<", p90 "<<s.p90_
+	 <<", min "<<s.min_<<", stddev "<<s.stddev_
+	 <<" ("<<s.samples_<<" x "<<s.iterations_<<" calls)";
+	return o;
+}
+
+test_runner::test_runner(const char* testname, const char* dir)
+: testname_(testname), dir_(dir), tests_() {}
 
 void test_runner::add(const char* name, const std::set<std::string>& tags, testfunc func) {
 	tests_.push_back(test_entry(name, tags, func));
@@ -190,28 +419,115 @@ void test_runner::add(const char* name, const std::set<std::string>& tags, testf
 	}
 }
 
+bool test_runner::run_test(const test_entry& e, bool verbose) {
+	bool ok = true;
+	std::string test;
+	test += dir_ + "/";
+	test += e.name_;
+	{
+		test_tool t(test, ok, verbose); // updates ok, when destroyed
+		(*e.func_)(t);
+	}
+	return ok;
+}
+
 bool test_runner::run(const std::set<std::string>& keys, bool verbose) {
 	bool ok = true;
 	map(keys, [&](const test_entry& e) {
-		std::string test;
-		test += "test/";
-		test += e.name_;
-		test_tool t(test, ok, verbose);
-		(*e.func_)(t);
+		ok &= run_test(e, verbose);
 	});
 	return ok;
 }
 
+// runs the tests in up to 'jobs' forked worker processes. each worker writes
+// its output into a temporary file, which is printed, when all the tests
+// before it are done, so the output is in the same order as in serial run.
+// the workers don't read stdin, so failed tests cannot be refrozen in this mode.
+bool test_runner::run(const std::set<std::string>& keys, bool verbose, int jobs) {
+	if (jobs <= 1) return run(keys, verbose);
+
+	struct job {
+		const test_entry* e_;
+		FILE* out_;
+		pid_t pid_;
+		bool done_;
+		bool ok_;
+	};
+	std::vector<job> js;
+	map(keys, [&](const test_entry& e) {
+		js.push_back(job{&e, 0, 0, false, false});
+	});
+
+	bool ok = true;
+	size_t started = 0, printed = 0;
+	int running = 0;
+	while (printed < js.size()) {
+		while (running < jobs && started < js.size()) {
+			job& j = js[started++];
+			j.out_ = tmpfile();
+			cout.flush(); // the worker would inherit the buffered output
+			fflush(0);
+			pid_t pid = j.out_ ? fork() : -1;
+			if (pid == 0) {
+				int null = open("/dev/null", O_RDONLY);
+				dup2(null, 0);
+				dup2(fileno(j.out_), 1);
+				dup2(fileno(j.out_), 2);
+				bool rv = run_test(*j.e_, verbose);
+				cout.flush();
+				_exit(rv ? 0 : 1);
+			} else if (pid < 0) {
+				cout<<j.e_->name_<<".. failed to start worker"<<endl;
+				j.done_ = true;
+			} else {
+				j.pid_ = pid;
+				running++;
+			}
+		}
+		while (printed < js.size() && js[printed].done_) {
+			job& j = js[printed++];
+			if (j.out_) {
+				rewind(j.out_);
+				char buf[4096];
+				size_t n;
+				while ((n = fread(buf, 1, sizeof(buf), j.out_)) > 0) {
+					cout.write(buf, n);
+				}
+				fclose(j.out_);
+			}
+			ok &= j.ok_;
+		}
+		if (running > 0) {
+			int status = 0;
+			pid_t pid = wait(&status);
+			for (job& j : js) {
+				if (j.pid_ == pid && !j.done_) {
+					j.done_ = true;
+					j.ok_ = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+					running--;
+				}
+			}
+		}
+	}
+	cout.flush();
+	return ok;
+}
+
 std::string test_runner::expfilepath(const std::string& testcase) {
-	return sup()<<"test/"<<testcase<<"_exp.txt";
+	return sup()<<dir_<<"/"<<testcase<<"_exp.txt";
 }
 
 int test_runner::exec(int argc, char** argv) {
 	int rv = 0;
 	bool list = false, print = false, verbose = false, path = false;
+	int jobs = 1;
 	set<string> keys;
 	for (int i = 1; i < argc; ++i) {
-		if (strcmp(argv[i], "-l") == 0) {
+		if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+			jobs = atoi(argv[++i]);
+		} else if (strncmp(argv[i], "-j", 2) == 0 && argv[i][2]) {
+			jobs = atoi(argv[i] + 2);
+		} else if (strcmp(argv[i], "-l") == 0) {
 			list = true;
 		} else if (strcmp(argv[i], "-p") == 0) {
 			print = true;
@@ -259,7 +575,7 @@ int test_runner::exec(int argc, char** argv) {
 		cout<<testname_<<"..\n\n";
 
 		time_sentry ms;
-		bool ok = run(keys, verbose);
+		bool ok = run(keys, verbose, jobs);
 		cout<<"\n";
 		cout<<ms.ms()<<"ms.. ";
 
@@ -326,7 +642,10 @@ const table& table::format(std::ostream& o, int precision) const {
 	buf.precision(precision);
 	buf.setf(std::ios::left, std::ios::adjustfield);
 
-	buf.width(12);
+	size_t ywidth = std::max(size_t(12), yprefix_.size() + 2);
+	for (const std::string& l : ylabels_) ywidth = std::max(ywidth, l.size() + 2);
+
+	buf.width(ywidth);
 	buf<<yprefix_;
 	for (size_t x = 0; x < xlabels_.size(); ++x) {
 		buf.width(12);
@@ -334,7 +653,7 @@ const table& table::format(std::ostream& o, int precision) const {
 	}
 	buf<<std::endl;
 	for (size_t y = 0; y < ylabels_.size(); ++y) {
-		buf.width(12);
+		buf.width(ywidth);
 		buf<<ylabels_[y];
 		for (size_t x = 0; x < xlabels_.size(); ++x) {
 			buf.width(12);
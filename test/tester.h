@@ -16,39 +16,130 @@
 #include <vector>
 #include <algorithm>
 #include <stdexcept>
+#include <stdint.h>
 #include <time.h>
 #include <sys/time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
 
 enum linemod_t {
 	checkl = 0,
 	ignorel,
 	reportl,
 	faill,
+	notel, // reported, but kept out of the output and the expectations
 };
 
+// measures elapsed time with the monotonic clock in nanosecond resolution.
+// on x86 the time stamp counter is read as well for cycle level measurements
 class time_sentry {
 private:
-	timeval begin_;
+	timespec begin_;
+	uint64_t tsc_;
 
 public:
-	time_sentry() : begin_() {
+	time_sentry() : begin_(), tsc_() {
 		reset();
 	}
 	void reset() {
-		gettimeofday(&begin_, 0);
+		clock_gettime(CLOCK_MONOTONIC, &begin_);
+		tsc_ = tsc();
 	}
 
-	size_t us() {
-		timeval end;
-		gettimeofday(&end, 0);
-		long secdiff = end.tv_sec - begin_.tv_sec;
-		long usecdiff = end.tv_usec - begin_.tv_usec;
-		usecdiff += 1000000 * secdiff;
-		return usecdiff;
+	static uint64_t tsc() {
+#if defined(__x86_64__) || defined(__i386__)
+		return __rdtsc();
+#else
+		return 0;
+#endif
+	}
+	// time stamp counter ticks, or 0 when not available
+	uint64_t ticks() const {
+		return tsc() - tsc_;
+	}
+	uint64_t ns() const {
+		timespec end;
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		return (end.tv_sec - begin_.tv_sec) * uint64_t(1000000000)
+			 + (end.tv_nsec - begin_.tv_nsec);
 	}
-	size_t ms() {
-		return us() / 1000;
+	size_t us() const {
+		return ns() / 1000;
 	}
+	size_t ms() const {
+		return ns() / 1000000;
+	}
+};
+
+class test_tool;
+
+// group of hardware counters (cycles, instructions, cache misses and branch misses)
+// read with perf_event_open. if the kernel doesn't allow the counters,
+// available() is false and the counters are simply not recorded
+class perf_counters {
+public:
+	enum counter {
+		cycles = 0,
+		instructions,
+		cache_misses,
+		branch_misses,
+		counter_count
+	};
+private:
+	int fds_[counter_count];
+	uint64_t ids_[counter_count];
+	uint64_t values_[counter_count];
+public:
+	perf_counters();
+	~perf_counters();
+	bool available() const;
+	bool available(counter c) const;
+	void start();
+	void stop();
+	uint64_t value(counter c) const;
+	static const char* name(counter c);
+	// records the available counters divided by calls with 'counter:' tags
+	void record(test_tool& t, const std::set<std::string>& tags, double calls = 1) const;
+};
+
+// how test_tool::bench samples the benchmarked function
+struct bench_options {
+	double warmup_ms_;  // time spent running the function before measuring
+	double sample_ms_;  // minimum duration of one sample; used to pick iteration count
+	int samples_;
+	bench_options(double warmup_ms = 5, double sample_ms = 2, int samples = 11)
+	: warmup_ms_(warmup_ms), sample_ms_(sample_ms), samples_(samples) {}
+};
+
+// statistics over repeated samples of ns per call
+struct sample_stats {
+	size_t iterations_; // calls per sample
+	size_t samples_;
+	double min_;
+	double max_;
+	double mean_;
+	double median_;
+	double p10_;
+	double p90_;
+	double stddev_;
+	sample_stats(std::vector<double> samples, size_t iterations);
+	double percentile(const std::vector<double>& sorted, double p);
+};
+
+std::ostream& operator<<(std::ostream& o, const sample_stats& s);
+
+// how test_tool::check_regressions compares the records against the frozen ones
+struct regression_options {
+	double threshold_; 				// relative change that is considered regression
+	double noise_;     				// required change in standard deviations, if they are recorded
+	bool lower_better_;
+	std::set<std::string> filter_;  // the compared records
+	regression_options(double threshold = 0.1,
+					   double noise = 3,
+					   bool lower_better = true,
+					   const std::set<std::string>& filter = {"stat:median"})
+	: threshold_(threshold), noise_(noise), lower_better_(lower_better), filter_(filter) {}
 };
 
 typedef std::pair<std::set<std::string>, double> record_entry;
@@ -103,8 +194,6 @@ struct filtered {
 	}
 };
 
-class test_tool;
-
 class report_output {
 	private:
 		test_tool& tool_;
@@ -138,6 +227,7 @@ class test_tool {
 		bool verbose_;
 		bool cleanline_;
 		bool frozen_;
+		bool recfrozen_; // whether the records have a baseline
 		bool fail_;
 		bool& ok_;
 		time_sentry time_;
@@ -155,6 +245,48 @@ class test_tool {
 
 		void record(const std::set<std::string>& tags, double value);
 
+		// records the statistics with 'stat:' tags, e.g. 'stat:median'
+		void record(const std::set<std::string>& tags, const sample_stats& stats);
+
+		// compares the records of this run against the frozen '_rec_exp' records,
+		// prints the deltas side by side and fails the test, if some record has
+		// regressed more than the threshold and the noise tolerance allow.
+		// returns the amount of regressions
+		int check_regressions(const regression_options& o = regression_options());
+
+		// benchmarks f: runs it for warm-up, calibrates the iteration count so that
+		// a sample lasts long enough to be timed, takes the samples and records the
+		// statistics of ns per call of f
+		template <typename F>
+		sample_stats bench(const std::set<std::string>& tags, F f,
+						   const bench_options& o = bench_options()) {
+			time_sentry warmup;
+			do {
+				f();
+			} while (warmup.us() < o.warmup_ms_ * 1000);
+
+			size_t n = 1;
+			while (true) {
+				time_sentry time;
+				for (size_t i = 0; i < n; ++i) f();
+				double us = time.ns() / 1000.;
+				if (us >= o.sample_ms_ * 1000) break;
+				// aim at the sample length directly once the timing is meaningful
+				size_t next = us > 100 ? size_t(n * (o.sample_ms_ * 1000) / us) + 1 : n * 2;
+				n = std::max(n * 2, std::min(next, n * 100));
+			}
+
+			std::vector<double> samples;
+			for (int s = 0; s < o.samples_; ++s) {
+				time_sentry time;
+				for (size_t i = 0; i < n; ++i) f();
+				samples.push_back(double(time.ns()) / n);
+			}
+			sample_stats rv(samples, n);
+			record(tags, rv);
+			return rv;
+		}
+
 		template <typename R, typename T = typename R::return_type>
 		T report(R r) const {
 			for (const record_entry& e : records_) {
@@ -175,6 +307,12 @@ class test_tool {
 			return report_output(*this, faill);
 		}
 
+		// for the output, which depends on the machine, e.g. on whether the
+		// hardware counters are available
+		report_output noted() {
+			return report_output(*this, notel);
+		}
+
 		template <typename T>
 		test_tool& operator<<(const T& c) {
 			std::ostringstream buf;
@@ -223,7 +361,7 @@ struct test_entry {
 
 class test_runner {
 	public:
-		test_runner(const char* testname);
+		test_runner(const char* testname, const char* dir = "test");
 		void add(const char* name, const std::set<std::string>& tags, testfunc func);
 		template <typename F>
 		void map(const std::set<std::string>& keys, F f) {
@@ -239,11 +377,15 @@ class test_runner {
 			}
 		}
 		bool run(const std::set<std::string>& keys, bool verbose = false);
+		bool run(const std::set<std::string>& keys, bool verbose, int jobs);
 		std::string expfilepath(const std::string& testcase);
 		int exec(int argc, char** argv);
 
 	private:
+		bool run_test(const test_entry& e, bool verbose);
+
 		std::string testname_;
+		std::string dir_;
 		std::vector<test_entry> tests_;
 };
 
@@ -1,7 +1,14 @@
 #include "toys/toys.h"
 #include "toys/text.h"
+#include "toys/flex.h"
+#include "toys/trace.h"
+#include "toys/term.h"
+#include "toys/mpsc.h"
+#include "toys/anim.h"
+#include "toys/flat.h"
 #include "toys/sdl.h"
 #include "tester.h"
+#include <thread>
 
 using namespace toys;
 using namespace toys::gen;
@@ -80,6 +87,10 @@ void test_split( test_tool& t ) {
 	t<<i.str()<<"\n";
 }
 
+// the clicks handled by the test toys, which tells whether the replayed
+// events reached the handlers
+int handled_clicks = 0;
+
 // return complex ui component as value
 template <typename _traits>
 auto complex_toy(const typename _traits::pixel_type* colors,
@@ -89,7 +100,7 @@ auto complex_toy(const typename _traits::pixel_type* colors,
 	auto h = x::lr(.5, x::rc(colors[0]), x::rc(colors[1]));
 	auto v = x::ud(.5, h, x::rc(colors[2]));
 	auto txt = x::tx(std::string("click!"), font, font_color);
-	auto mid = x::on_click([](click& c){ system::exit(0); }, x::fb(x::lay(xy(0.5, 0.5), txt), x::rc(colors[3])));
+	auto mid = x::on_click([](click& c){ handled_clicks++; system::exit(0); }, x::fb(x::lay(xy(0.5, 0.5), txt), x::rc(colors[3])));
 	auto w = x::lay(xy(.5, .5), x::sz(xy(.5, .5), mid));
 	return x::fb(w, v);
 }
@@ -139,13 +150,527 @@ void test_ssplit( test_tool& t ) {
 	t<<i.str()<<"\n";
 }
 
+void test_any( test_tool& t ) {
+	text_image i(vec(16, 16));
+	typedef box<baseless_text_traits, value_copy> x;
+	typedef any_toy<baseless_text_traits> any;
+	std::vector<any> toys;
+	toys.push_back(x::rc('a'));
+	toys.push_back(x::lr(0.5, x::rc('b'), x::rc('c')));
+	toys.push_back(complex_toy<baseless_text_traits>(text_colors));
+	toys.push_back(x::at(vec(2, 1), x::tx(std::string("any"), nothing(), nothing())));
+	any copy(toys[2]);
+	toys.push_back(copy);
+	t<<"the handle size is "<<sizeof(any)<<" bytes\n";
+	t<<"the handle moves without throwing: "<<std::is_nothrow_move_constructible<any>::value<<"\n\n";
+	for (size_t j = 0; j < toys.size(); ++j) {
+		t<<"toy "<<j<<" is "<<(toys[j].inlined() ? "inline" : "in heap")<<"\n";
+	}
+	t<<"\n";
+	auto z = x::ud(4, x::lr(8, toys[0], toys[1]), x::fb(toys[3], toys[4]));
+	z->draw(i.sz(), i.g());
+	click c(vec(8, 8));
+	t<<"click "<<(z->recv(i.sz(), c) ? "received" : "ignored")<<"\n\n";
+	t<<i.str()<<"\n";
+}
+
+void test_srow( test_tool& t ) {
+	text_image i(vec(16, 16));
+	typedef box<baseless_text_traits, value_copy> x;
+	auto r = x::row(x::rc('a'), x::rc('b'), x::rc('c'));
+	t<<"the ui component size is "<<sizeof(decltype(r))<<" bytes\n\n";
+	int clicked = -1;
+	auto z = x::col(r,
+					x::on_click([&clicked](click&){ clicked = 1; }, x::rc('d')),
+					x::row(x::rc('e'), x::at(vec(1, 2), x::tx(std::string("row"), nothing(), nothing())),
+						   x::on_click([&clicked](click&){ clicked = 2; }, x::rc('f'))));
+	z->draw(i.sz(), i.g());
+	for (vec p : {vec(2, 2), vec(8, 8), vec(13, 13), vec(8, 13)}) {
+		clicked = 0;
+		click c(p);
+		bool rv = z->recv(i.sz(), c);
+		t<<"click at "<<p.x()<<","<<p.y()<<" -> "<<rv<<", handler "<<clicked<<"\n";
+	}
+	t<<"\n"<<i.str()<<"\n";
+}
+
+// box of fixed content size, which counts how many times it gets measured
+class measured_box : public itoy<text_traits> {
+private:
+	vec content_;
+	char c_;
+public:
+	mutable int measures_;
+	measured_box(const vec& content, char c) : content_(content), c_(c), measures_() {}
+	vec size(const vec& ) const {
+		measures_++;
+		return content_;
+	}
+	void draw(const vec& size, text_graphics& g) const {
+		fill_rect(g, size, c_);
+	}
+	bool recv(const vec& size, ievent& e) { return e.hit(size); }
+};
+
+void test_flex( test_tool& t ) {
+	measured_box a(vec(4, 1), 'a'), b(vec(4, 1), 'b'), c(vec(2, 1), 'c'), d(vec(12, 1), 'd');
+	flex<text_traits> f(0);
+	f.add(&a);
+	f.add(&b, flex_item(1));
+	f.add(&c, flex_item(2, 1, 0, 4));
+	flex<text_traits> s(0);
+	s.add(&d, flex_item(0, 1, 8));
+	s.add(&f, flex_item(0, 1));
+
+	text_image i(vec(16, 4));
+	f.draw(vec(16, 2), i.g());
+	f.draw(vec(16, 2), i.g());
+	t<<"grow: "<<f.measures()<<" measures after two draws\n";
+	{
+		auto ts = i.g().translation(vec(0, 2));
+		s.draw(vec(16, 2), i.g());
+	}
+	t<<"shrink: "<<s.measures()<<" measures\n\n";
+	t<<i.str()<<"\n\n";
+
+	click k(vec(13, 0));
+	t<<"click "<<f.recv(vec(16, 2), k)<<", "<<f.measures()<<" measures\n";
+	f.invalidate(1);
+	f.draw(vec(16, 2), i.g());
+	t<<"child changed, "<<f.measures()<<" measures\n";
+	f.draw(vec(12, 2), i.g());
+	t<<"width changed, "<<f.measures()<<" measures\n";
+	t<<"per child: "<<a.measures_<<" "<<b.measures_<<" "<<c.measures_<<"\n";
+	flex<text_traits> u(1);
+	u.add(&a);
+	u.add(&c);
+	vec content = u.size(vec(16, 8));
+	t<<"content size "<<content.x()<<"x"<<content.y()<<" in 16x8\n";
+}
+
+void test_spans( test_tool& t ) {
+	// the text image's line breaks are within the buffer, so the right edge
+	// is tested with a plain buffer
+	vec sz(16, 8, 1);
+	std::vector<char> buf(sz.volume(), ' ');
+	text_graphics g(sz, buf.data());
+	typedef box<baseless_text_traits, value_copy> x;
+	// rectangles and texts crossing each of the edges get clipped
+	x::at(vec(-3, -2), x::sz(vec(6, 4), x::rc('a')))->draw(sz, g);
+	x::at(vec(12, 1), x::sz(vec(8, 2), x::rc('b')))->draw(sz, g);
+	x::at(vec(5, 6), x::sz(vec(4, 8), x::rc('c')))->draw(sz, g);
+	x::at(vec(-2, 4), x::tx(std::string("clipped"), nothing(), nothing()))->draw(sz, g);
+	x::at(vec(10, 5), x::tx(std::string("clipped"), nothing(), nothing()))->draw(sz, g);
+	x::at(vec(20, 3), x::tx(std::string("outside"), nothing(), nothing()))->draw(sz, g);
+	g.fill_span(vec(4, 2), 3, 'd');
+	g.blit(vec(9, 3), "blit", 4);
+	for (int y = 0; y < sz.y(); ++y) {
+		t<<std::string(&buf[y * sz.x()], sz.x())<<"|\n";
+	}
+}
+
+// text that counts how it gets constructed
+struct counted_text {
+	static int constructed_;
+	static int copied_;
+	std::string s_;
+	counted_text(const char* s) : s_(s) { constructed_++; }
+	counted_text(const counted_text& c) : s_(c.s_) { copied_++; }
+	counted_text(counted_text&& c) : s_(std::move(c.s_)) {}
+	std::string::const_iterator begin() const { return s_.begin(); }
+	std::string::const_iterator end() const { return s_.end(); }
+};
+int counted_text::constructed_ = 0;
+int counted_text::copied_ = 0;
+
+template <typename _traits, int _depth>
+struct counted_tree {
+	typedef box<_traits, value_copy> x;
+	static auto make() {
+		return x::lr(0.5, x::ud(0.5, counted_tree<_traits, _depth-1>::make(),
+									 counted_tree<_traits, _depth-1>::make()),
+						  x::lay(mid, x::sz(xy(.5, .5), counted_tree<_traits, _depth-1>::make())));
+	}
+};
+template <typename _traits>
+struct counted_tree<_traits, 0> {
+	typedef box<_traits, value_copy> x;
+	static auto make() {
+		return x::on_click([](click&){}, x::tx(counted_text("leaf"), nothing(), nothing()));
+	}
+};
+
+template <int _depth>
+void build_counted_tree(test_tool& t, int times) {
+	counted_text::constructed_ = counted_text::copied_ = 0;
+	time_sentry time;
+	for (int i = 0; i < times; ++i) {
+		auto z = counted_tree<baseless_text_traits, _depth>::make();
+		(void)z;
+	}
+	double ns = (time.us() * 1000.) / times;
+	t<<"depth "<<_depth<<": "
+	 <<(counted_text::constructed_/times)<<" leaves constructed, "
+	 <<(counted_text::copied_/times)<<" copied\n";
+	t.record({"op:build", sup()<<"depth:"<<_depth}, ns);
+}
+
+void test_copies( test_tool& t ) {
+	build_counted_tree<1>(t, 10000);
+	build_counted_tree<2>(t, 10000);
+	build_counted_tree<3>(t, 1000);
+	build_counted_tree<4>(t, 1000);
+	t<<"\nns per tree:\n";
+	t.ignored()<<t.report(to_table<average>({}, "op:", "depth:"));
+}
+
+// text traits with the chrome trace policy
+struct traced_text_traits : public baseless_text_traits {
+	typedef chrome_trace trace_type;
+};
+
+struct traced_itoy_traits : public text_traits {
+	typedef chrome_trace trace_type;
+};
+
+void test_trace( test_tool& t ) {
+	text_image i(vec(16, 8));
+	typedef box<traced_text_traits, value_copy> x;
+	t<<"untraced traits trace "<<(std::is_same<trace_of<baseless_text_traits>::type, null_trace>::value ? "nothing" : "calls")<<"\n";
+	t<<"traced traits trace "<<(std::is_same<trace_of<traced_text_traits>::type, null_trace>::value ? "nothing" : "calls")<<"\n\n";
+	auto z = x::ud(4, x::lr(8, x::rc('a'), x::at(vec(1, 1), x::tx(std::string("tr"), nothing(), nothing()))),
+					  x::on_click([](click&){}, x::sz(xy(.5, .5), x::rc('b'))));
+	chrome_trace::clear();
+	z->draw(i.sz(), i.g());
+	click c(vec(2, 5));
+	z->recv(i.sz(), c);
+	std::vector<trace_event> events = trace_ring::local().events();
+	t<<events.size()<<" events in completion order:\n";
+	for (const trace_event& e : events) {
+		t<<"  "<<e.name_<<(e.begin_ <= e.end_ ? "" : " (negative duration)")<<"\n";
+	}
+	std::ostringstream json;
+	chrome_trace::write(json);
+	std::string js = json.str();
+	size_t n = 0;
+	for (size_t p = js.find("\"ph\":\"X\""); p != std::string::npos; p = js.find("\"ph\":\"X\"", p + 1)) n++;
+	t<<"\n"<<n<<" complete events in chrome trace\n";
+	t<<"\n"<<i.str()<<"\n";
+}
+
+// escape sequences made printable
+std::string escaped(const std::string& s) {
+	std::string rv;
+	for (char c : s) {
+		if (c == '\x1b') rv += "^[";
+		else rv += c;
+	}
+	return rv;
+}
+
+void test_term( test_tool& t ) {
+	typedef box<text_traits, value_copy> x;
+	term::screen s(vec(16, 4));
+	auto z = x::ud(2, x::lr(8, x::rc('a'), x::at(vec(1, 0), x::tx(std::string("term"), nothing(), nothing()))),
+					  x::rc('b'));
+	z->draw(s.size(), s.g());
+	const char red = term::attr(2);
+	x::sz(vec(2, 1), x::rc(red))->draw(s.size(), s.attrs());
+	t<<"first frame:\n";
+	t<<escaped(s.present())<<"\n";
+	t<<s.changed()<<" cells written\n\n";
+
+	t<<"same frame:\n";
+	s.clear();
+	z->draw(s.size(), s.g());
+	x::sz(vec(2, 1), x::rc(red))->draw(s.size(), s.attrs());
+	t<<escaped(s.present())<<"\n";
+	t<<s.changed()<<" cells written\n\n";
+
+	t<<"changed text and colors:\n";
+	s.clear();
+	auto w = x::ud(2, x::lr(8, x::rc('a'), x::at(vec(1, 0), x::tx(std::string("team"), nothing(), nothing()))),
+					  x::rc('b'));
+	w->draw(s.size(), s.g());
+	x::at(vec(0, 3), x::sz(vec(16, 1), x::rc(term::attr(0, 5))))->draw(s.size(), s.attrs());
+	t<<escaped(s.present())<<"\n";
+	t<<s.changed()<<" cells written\n\n";
+
+	t<<"invalidated:\n";
+	s.invalidate();
+	t<<escaped(s.present())<<"\n";
+	t<<s.changed()<<" cells written\n";
+}
+
+void test_flat( test_tool& t ) {
+	typedef box<text_traits, value_copy> x;
+	typedef flat::tree<text_traits> f;
+	int gen_clicks[2] = {0, 0}, flat_clicks[2] = {0, 0};
+	auto g = x::ud(2, x::lay(vec(5, 1), x::tx(std::string("title"), nothing(), nothing())),
+					  x::lr(.5, x::on_click([&gen_clicks](click&) { gen_clicks[0]++; },
+											x::fb(x::at(vec(1, 1), x::sz(vec(4, 2), x::rc('#'))),
+												  x::rc('.'))),
+								x::on_click([&gen_clicks](click&) { gen_clicks[1]++; },
+											x::sz(xy(.75, 1.), x::at(vec(1, 1), x::tx(std::string("right"), nothing(), nothing()))))));
+	f z = f::ud(2, f::lay(vec(5, 1), f::tx("title")),
+				   f::lr(.5, f::on_click([&flat_clicks](click&) { flat_clicks[0]++; },
+										 f::fb(f::at(vec(1, 1), f::sz(vec(4, 2), f::rc('#'))),
+											   f::rc('.'))),
+							 f::on_click([&flat_clicks](click&) { flat_clicks[1]++; },
+										 f::sz(flat::tr(.75, 1.), f::at(vec(1, 1), f::tx("right"))))));
+	text_image gi(vec(16, 6)), fi(vec(16, 6));
+	g->draw(gi.sz(), gi.g());
+	z.draw(fi.sz(), fi.g());
+	t<<z.count()<<" nodes\n\n"<<fi.str()<<"\n\n";
+	t<<"same drawing: "<<(std::string(gi.str()) == fi.str())<<"\n";
+	t<<"same size: "<<(g->size(vec(16, 6)) == z.size(vec(16, 6)))<<"\n";
+	int same = 0, taken = 0, points = 0;
+	for (int py = -1; py <= 7; ++py) {
+		for (int px = -1; px <= 17; ++px) {
+			click a(vec(px, py)), b(vec(px, py));
+			bool ra = g->recv(vec(16, 6), a);
+			bool rb = z.recv(vec(16, 6), b);
+			same += ra == rb;
+			taken += rb;
+			points++;
+		}
+	}
+	t<<"same result on "<<same<<" of "<<points<<" points, "<<taken<<" taken\n";
+	t<<"clicks "<<flat_clicks[0]<<" and "<<flat_clicks[1]<<", same as gen: "
+	 <<(gen_clicks[0] == flat_clicks[0] && gen_clicks[1] == flat_clicks[1])<<"\n";
+}
+
+void test_mpsc( test_tool& t ) {
+	const int producers = 4, values = 10000;
+	mpsc_queue<std::pair<int, int>> q;
+	std::vector<std::thread> threads;
+	for (int p = 0; p < producers; ++p) {
+		threads.emplace_back([&q, p, values]() {
+			for (int i = 0; i < values; ++i) q.push(std::make_pair(p, i));
+		});
+	}
+	// consumed while the producers are still pushing
+	std::vector<int> next(producers);
+	int popped = 0, misordered = 0;
+	std::pair<int, int> v;
+	while (popped < producers * values) {
+		if (!q.pop(v)) continue;
+		if (v.second != next[v.first]) misordered++;
+		next[v.first] = v.second + 1;
+		popped++;
+	}
+	for (std::thread& th : threads) th.join();
+	t<<popped<<" values popped from "<<producers<<" producers\n";
+	t<<misordered<<" out of the producer's order\n";
+	t<<"empty after: "<<q.empty()<<"\n";
+}
+
+void test_clip( test_tool& t ) {
+	text_image i(vec(16, 8));
+	typedef box<traced_text_traits, value_copy> x;
+	// list of 8 rows, 2 lines each, scrolled up by 5 lines in a viewport of 6 lines
+	auto list = x::col(x::rc('0'), x::rc('1'), x::rc('2'), x::rc('3'),
+					   x::rc('4'), x::rc('5'), x::rc('6'), x::rc('7'));
+	auto z = x::ud(2, x::rc('-'),
+					  x::lr(12, x::clip(x::at(vec(0, -5), x::sz(vec(12, 16), list))),
+								x::rc('|')));
+	chrome_trace::clear();
+	z->draw(i.sz(), i.g());
+	size_t rects = 0;
+	for (const trace_event& e : trace_ring::local().events()) {
+		if (std::string(e.name_) == "rect.draw") rects++;
+	}
+	t<<rects<<" of 10 rectangles drawn\n\n";
+	t<<i.str()<<"\n";
+}
+
+// the traced recv calls since the latest clear
+size_t count_recvs() {
+	size_t rv = 0;
+	for (const trace_event& e : trace_ring::local().events()) {
+		std::string n(e.name_);
+		if (n.size() > 5 && n.compare(n.size() - 5, 5, ".recv") == 0) rv++;
+	}
+	return rv;
+}
+
+void test_interest( test_tool& t ) {
+	typedef box<traced_text_traits, value_copy> x;
+	int clicked = 0;
+	auto header = x::row(x::rc('a'), x::at(vec(1, 0), x::tx(std::string("header"), nothing(), nothing())));
+	auto button = x::on_click([&clicked](click&) { clicked++; }, x::rc('b'));
+	auto z = x::ud(2, header, x::fb(x::sz(vec(4, 1), x::rc('f')), button));
+	t<<"interests: header "<<header->interest()<<", button "<<button->interest()
+	 <<", all "<<z->interest()<<"\n";
+	for (vec p : {vec(1, 1), vec(1, 2), vec(8, 4)}) {
+		chrome_trace::clear();
+		click c(p);
+		bool rv = z->recv(vec(16, 6), c);
+		t<<"click at "<<p.x()<<","<<p.y()<<" -> "<<rv<<" after "<<count_recvs()<<" recvs\n";
+	}
+	pointevent pe(vec(8, 4));
+	t<<"pointevent on the button -> "<<z->recv(vec(16, 6), pe)<<"\n";
+	// the label behind an itoy tells its interest and hits in run time, so
+	// the clicks skip it like a value label
+	auto label = x::at(vec(1, 0), x::tx(std::string("label"), nothing(), nothing()));
+	std::shared_ptr<itoy<text_traits>> deco = std::make_shared<wrap<traced_itoy_traits, decltype(label)>>(label);
+	auto v = x::ud(2, deco, x::fb(x::sz(vec(4, 1), x::rc('f')), button));
+	const char* hits[] = {"none", "size", "shape"};
+	t<<"itoy label: interest "<<deco->interest()<<", hits "<<hits[deco->takes()]<<"\n";
+	chrome_trace::clear();
+	click c(vec(8, 4));
+	bool rv = v->recv(vec(16, 6), c);
+	t<<"click at 8,4 below the itoy label -> "<<rv<<" after "<<count_recvs()<<" recvs\n";
+	t<<clicked<<" clicks\n";
+}
+
+template <typename _toy>
+void draw_layers(test_tool& t, const char* name, const _toy& z) {
+	text_image i(vec(16, 6));
+	chrome_trace::clear();
+	z->draw(i.sz(), i.g());
+	size_t rects = 0;
+	for (const trace_event& e : trace_ring::local().events()) {
+		if (std::string(e.name_) == "rect.draw") rects++;
+	}
+	t<<name<<": "<<(z->opaque(i.sz()) ? "opaque" : "transparent")<<", rectangles drawn: "<<rects<<"\n";
+	t<<i.str()<<"\n\n";
+}
+
+void test_occlusion( test_tool& t ) {
+	typedef box<traced_text_traits, value_copy> x;
+	draw_layers(t, "covering front", x::fb(x::row(x::rc('f'), x::rc('g')), x::rc('b')));
+	draw_layers(t, "front over top rows", x::fb(x::sz(vec(16, 2), x::rc('f')), x::rc('b')));
+	draw_layers(t, "front over left columns", x::fb(x::sz(vec(4, 6), x::rc('f')), x::rc('b')));
+	draw_layers(t, "front in the middle", x::fb(x::lay(mid, x::sz(vec(4, 2), x::rc('f'))), x::rc('b')));
+	draw_layers(t, "text front", x::fb(x::lay(mid, x::tx(std::string("text"), nothing(), nothing())), x::rc('b')));
+	draw_layers(t, "covered stack", x::fb(x::rc('f'), x::fb(x::lay(mid, x::tx(std::string("text"), nothing(), nothing())), x::rc('b'))));
+}
+
+void test_cached( test_tool& t ) {
+	typedef box<traced_text_traits, value_copy> x;
+	auto cache = std::make_shared<x::cache_type>();
+	int clicks = 0;
+	// the cached text is transparent around the text
+	auto z = x::fb(x::cached(cache, x::on_click([&clicks](click&) { clicks++; },
+												x::lay(mid, x::tx(std::string("cached"), nothing(), nothing())))),
+				   x::rc('.'));
+	text_image i(vec(16, 4));
+	auto draw = [&](const char* what, const vec& sz) {
+		chrome_trace::clear();
+		z->draw(sz, i.g());
+		size_t texts = 0;
+		for (const trace_event& e : trace_ring::local().events()) {
+			if (std::string(e.name_) == "text.draw") texts++;
+		}
+		t<<what<<": "<<cache->renders()<<" renders, texts drawn: "<<texts<<"\n";
+	};
+	draw("first draw", i.sz());
+	draw("second draw", i.sz());
+	draw("third draw", i.sz());
+	t<<"\n"<<i.str()<<"\n\n";
+	draw("resized", vec(12, 4));
+	cache->invalidate();
+	draw("invalidated", vec(12, 4));
+	click c(vec(6, 2));
+	z->recv(vec(12, 4), c);
+	draw("clicked", vec(12, 4));
+	draw("drawn again", vec(12, 4));
+	t<<"\n"<<clicks<<" clicks\n\n"<<i.str()<<"\n";
+}
+
+void test_anim( test_tool& t ) {
+	typedef box<text_traits, value_copy> x;
+	double now = 0;
+	anim::frame_clock clock([&now]() { return now; });
+	anim::tween<float> width(clock, 2);
+	auto label = std::make_shared<x::cache_type>();
+	auto bar = std::make_shared<x::cache_type>();
+	// only the bar's layer reads the animated width
+	auto z = x::ud(1, x::cached(label, x::tx(std::string("progress"), nothing(), nothing())),
+					  x::fb(x::cached(bar, x::sz([width](const vec& s) { return vec(int(width), s.y()); },
+											   x::rc('#'))),
+							x::rc('.')));
+	text_image i(vec(12, 2));
+	auto frame = [&]() {
+		z->draw(i.sz(), i.g());
+		t<<"t="<<now<<": "<<label->renders()<<" label renders, "<<bar->renders()<<" bar renders, "
+		 <<(clock.active() ? "active" : "settled")<<"\n"<<i.str()<<"\n";
+	};
+	frame();
+	width.to(10, 1, &anim::linear);
+	while (clock.active()) {
+		now += .25;
+		clock.tick();
+		frame();
+	}
+	t<<clock.ticks()<<" ticks\n\n";
+
+	anim::spring s(clock, 0);
+	s.to(10);
+	size_t ticks = clock.ticks();
+	float peak = 0;
+	while (clock.active()) {
+		now += 1. / 60;
+		clock.tick();
+		peak = std::max(peak, s.get());
+	}
+	t<<"spring settled at "<<s.get()<<" after "<<clock.ticks() - ticks<<" ticks, ";
+	t<<"overshoot: "<<(peak > 10.f)<<"\n";
+	now = 20;
+	frame();
+	t<<"no ticks after settling: "<<(!clock.active())<<"\n";
+}
+
 const char* font_path = "/usr/share/fonts/truetype/freefont/FreeMono.ttf";
 //const char* font_path = "/usr/share/fonts/truetype/msttcorefonts/Arial.ttf";
 //const char* font_path = "/usr/share/fonts/truetype/ubuntu-font-family/UbuntuMono-B.ttf";
 int font_size = 20;
 
+void test_framestats( test_tool& t ) {
+	sdl::frame_stats s;
+	typedef sdl::frame_stats fs;
+	for (size_t i = 0; i < fs::frames + 32; ++i) {
+		s.add_events(100);
+		s.add_events(i % 4 == 0 ? 900 : 0);
+		s.add_frame(2000 + 100 * (i % 10), i % 16 == 0 ? 20000 : 500);
+	}
+	t<<s.count()<<" frames recorded, "<<s.size()<<" in the window\n\n";
+	for (size_t p = 0; p < fs::phase_count; ++p) {
+		fs::phase ph = fs::phase(p);
+		t<<fs::name(ph)<<": last "<<s.last(ph)<<"us, p50 "<<s.percentile(ph, .5)
+		 <<"us, p90 "<<s.percentile(ph, .9)<<"us\n";
+		t<<"  histogram:";
+		size_t n = 0;
+		for (size_t b = 0; b < fs::buckets; ++b) {
+			t<<" "<<s.histogram(ph)[b];
+			n += s.histogram(ph)[b];
+		}
+		t<<" ("<<n<<" frames)\n";
+	}
+}
+
+// the sdl tests replay the events recorded in the test's directory without
+// a display. when there is no recording, the events are recorded from the user.
+template <typename _reactor>
+void interact(test_tool& t, sdl::event_replay& replay, _reactor& r) {
+	handled_clicks = 0;
+	if (replay.size()) {
+		replay.run(r);
+	} else {
+		sdl::event_recorder recorder(t.file_path("events.txt"));
+		r.record(&recorder);
+		r.run();
+		r.record(nullptr);
+	}
+	t<<handled_clicks<<" clicks handled\n";
+	t<<"exit value "<<system::exit_value()<<"\n";
+}
+
 void test_sdlbox( test_tool& t ) {
 	using namespace sdl;
+	sdl::event_replay replay;
+	if (replay.load(t.file_path("events.txt"))) sdl::sdltoys::headless();
 	sdl::sdltoys infra;
 	rgba colors[4] = {
 		{255, 0, 0, 255},
@@ -153,26 +678,135 @@ void test_sdlbox( test_tool& t ) {
 		{0, 0, 255, 255},
 		{255, 255, 255, 255}
 	};
-	TTF_Font *font = nullptr;
-	font = TTF_OpenFont(font_path, font_size);
+	sdl::font font = font_registry::instance().get(font_path, font_size);
 	auto z = complex_toy<sdl::baseless_traits>(colors, font, {0, 0, 0, 255});
 	vec sz(256, 256);
 	sdl::window<decltype(z)> wnd("foo", vec(), sz, z);
+	wnd.show_hud(font);
 	sdl::reactor<sdl::window<decltype(z)>*> r(&wnd);
 	wnd.draw();
+	interact(t, replay, r);
+}
+
+void test_sdlfonts( test_tool& t ) {
+	using namespace sdl;
+	sdl::sdltoys infra;
+	font_registry& r = font_registry::instance();
+	sdl::font a = r.get(font_path, font_size);
+	sdl::font b(font_path, font_size);
+	t<<"same key shares the face: "<<(a.face() == b.face())<<"\n";
+	t<<"bigger size shares the face: "<<(a.face() == r.get(font_path, 2*font_size).face())<<"\n";
+	t<<r.loaded()<<" of "<<r.size()<<" fonts loaded before use\n";
+	typedef box<sdl::baseless_traits, value_copy> x;
+	auto z = x::tx(std::string("lazy"), a, rgba{0, 0, 0, 255});
+	t<<r.loaded()<<" of "<<r.size()<<" fonts loaded after building a text\n";
+	rgba colors[4] = {};
+	complex_toy<sdl::baseless_traits>(colors, a, rgba{0, 0, 0, 255});
+	t<<r.loaded()<<" of "<<r.size()<<" fonts loaded after building a toy of the traits' fonts\n";
+	z->size(vec());
+	t<<r.loaded()<<" of "<<r.size()<<" fonts loaded after measuring it\n";
+	r.preload({font_spec(font_path, 2*font_size), font_spec(font_path, font_size/2)});
+	r.wait();
+	t<<r.loaded()<<" of "<<r.size()<<" fonts loaded after preloading\n";
+}
+
+void test_sdltasks( test_tool& t ) {
+	using namespace sdl;
+	sdl::sdltoys::headless();
+	sdl::sdltoys infra;
+	typedef box<sdl::baseless_traits, value_copy> x;
+	int value = 0;
+	auto z = x::rc(rgba{255, 255, 255, 255});
+	sdl::window<decltype(z)> wnd("foo", vec(), vec(64, 64), z);
+	sdl::reactor<sdl::window<decltype(z)>*> r(&wnd);
+	// a feed of 4 threads, whose tasks touch the value in the ui thread only
+	std::vector<std::thread> threads;
+	for (int i = 0; i < 4; ++i) {
+		threads.emplace_back([&r, &value]() {
+			for (int j = 0; j < 1000; ++j) r.post([&value]() { value++; });
+		});
+	}
+	for (std::thread& th : threads) th.join();
+	r.post([]() { system::exit(0); });
+	t<<"exit value "<<r.run()<<"\n";
+	t<<"value "<<value<<"\n";
+	t<<r.batches()<<" batches of at most "<<size_t(sdl::task_queue::max_batch)<<" tasks\n";
+	t<<wnd.stats().count()<<" frames drawn\n";
+}
+
+void test_sdlwindows( test_tool& t ) {
+	using namespace sdl;
+	sdl::sdltoys::headless();
+	sdl::sdltoys infra;
+	typedef box<sdl::baseless_traits, value_copy> x;
+	int a_clicks = 0, b_clicks = 0;
+	auto a = x::on_click([&a_clicks](click&) { a_clicks++; }, x::rc(rgba{255, 0, 0, 255}));
+	auto b = x::on_click([&b_clicks](click&) { b_clicks++; }, x::rc(rgba{0, 0, 255, 255}));
+	sdl::window<decltype(a)> wa("a", vec(), vec(64, 64), a);
+	sdl::window<decltype(b)> wb("b", vec(), vec(64, 64), b);
+	// the new windows have their shown events queued, while the first
+	// frames below draw them anyway
+	SDL_PumpEvents();
+	SDL_FlushEvents(SDL_FIRSTEVENT, SDL_LASTEVENT);
+	sdl::multi_reactor r;
+	r.add(wa);
+	r.add(wb);
+	auto push_click = [](Uint32 id) {
+		SDL_Event e = SDL_Event();
+		e.button.type = SDL_MOUSEBUTTONDOWN;
+		e.button.windowID = id;
+		e.button.x = e.button.y = 32;
+		SDL_PushEvent(&e);
+	};
+	auto push_window = [](Uint32 id, Uint8 event) {
+		SDL_Event e = SDL_Event();
+		e.window.type = SDL_WINDOWEVENT;
+		e.window.windowID = id;
+		e.window.event = event;
+		SDL_PushEvent(&e);
+	};
+	auto push_quit = []() {
+		SDL_Event e = SDL_Event();
+		e.type = SDL_QUIT;
+		SDL_PushEvent(&e);
+	};
+	auto report = [&](const char* what) {
+		t<<what<<": clicks "<<a_clicks<<" / "<<b_clicks
+		 <<", frames "<<wa.stats().count()<<" / "<<wb.stats().count()
+		 <<", "<<r.size()<<" windows\n";
+	};
+	r.draw_dirty();
+	report("first frames");
+	push_click(wb.id());
+	push_click(wb.id());
+	push_click(wb.id());
+	push_quit();
+	r.run();
+	report("three clicks in b");
+	push_window(wa.id(), SDL_WINDOWEVENT_EXPOSED);
+	push_click(wa.id() + wb.id()); // no such window
+	push_quit();
 	r.run();
-	TTF_CloseFont(font);
+	report("a exposed");
+	push_window(wb.id(), SDL_WINDOWEVENT_CLOSE);
+	push_click(wb.id());
+	push_click(wa.id());
+	push_window(wa.id(), SDL_WINDOWEVENT_CLOSE);
+	t<<"exit value "<<r.run()<<"\n";
+	report("both closed");
+	t<<"shown after closing: "<<wa.shown()<<" / "<<wb.shown()<<"\n";
 }
 
 void test_sdltext( test_tool& t ) {
 	using namespace sdl;
+	sdl::event_replay replay;
+	if (replay.load(t.file_path("events.txt"))) sdl::sdltoys::headless();
 	sdl::sdltoys infra;
 	typedef box<sdl::baseless_traits, value_copy> x;
-	TTF_Font *font = nullptr;
-	font = TTF_OpenFont(font_path, font_size);
+	sdl::font font = font_registry::instance().get(font_path, font_size);
 //	typedef toys::sdl::text<sdl::baseless_traits, std::string, TTF_Font*, rgba> sdltext;
 	rgba color = {0, 0, 0, 255};
-	auto z = x::on_click([](click& c){ system::exit(0); },
+	auto z = x::on_click([](click& c){ handled_clicks++; system::exit(0); },
 					     x::fb(x::lay(xy(0.5, 0.5),
 					    	          x::tx(std::string("foo"), font, color)),
 					           x::rc(rgba{255, 255, 255, 255})));
@@ -180,8 +814,31 @@ void test_sdltext( test_tool& t ) {
 	sdl::window<decltype(z)> wnd("foo", vec(), sz, z);
 	sdl::reactor<sdl::window<decltype(z)>*> r(&wnd);
 	wnd.draw();
-	r.run();
-	TTF_CloseFont(font);
+	interact(t, replay, r);
+}
+
+// the first click hits the cached rectangle behind the any_toy handle, but
+// nothing inside takes it, so the layer stays valid. the second one exits.
+void test_sdlcached( test_tool& t ) {
+	using namespace sdl;
+	sdl::event_replay replay;
+	if (replay.load(t.file_path("events.txt"))) sdl::sdltoys::headless();
+	sdl::sdltoys infra;
+	typedef box<sdl::baseless_traits, value_copy> x;
+	sdl::font font = font_registry::instance().get(font_path, font_size);
+	rgba color = {0, 0, 0, 255};
+	auto cache = std::make_shared<x::cache_type>();
+	auto z = x::fb(x::lay(xy(0.5, 0.5),
+						  x::on_click([](click& c){ handled_clicks++; system::exit(0); },
+									  x::tx(std::string("foo"), font, color))),
+				   x::cached(cache, sdl::any_toy(x::rc(rgba{255, 255, 255, 255}))));
+	vec sz(256, 256);
+	sdl::window<decltype(z)> wnd("foo", vec(), sz, z);
+	sdl::reactor<sdl::window<decltype(z)>*> r(&wnd);
+	wnd.draw();
+	interact(t, replay, r);
+	wnd.draw();
+	t<<"layer renders after a redraw: "<<cache->renders()<<"\n";
 }
 
 void add_toy_tests(test_runner& runner) {
@@ -196,7 +853,26 @@ void add_toy_tests(test_runner& runner) {
 	runner.add("toys/srect", std::set<std::string>(), &test_srect);
 	runner.add("toys/ssz", std::set<std::string>(), &test_ssz);
 	runner.add("toys/ssplit",  std::set<std::string>(), &test_ssplit);
+	runner.add("toys/any",  std::set<std::string>(), &test_any);
+	runner.add("toys/srow",  std::set<std::string>(), &test_srow);
+	runner.add("toys/flex",  std::set<std::string>(), &test_flex);
+	runner.add("toys/flat",  std::set<std::string>(), &test_flat);
+	runner.add("toys/spans",  std::set<std::string>(), &test_spans);
+	runner.add("toys/copies",  std::set<std::string>(), &test_copies);
+	runner.add("toys/trace",  std::set<std::string>(), &test_trace);
+	runner.add("toys/clip",  std::set<std::string>(), &test_clip);
+	runner.add("toys/interest",  std::set<std::string>(), &test_interest);
+	runner.add("toys/occlusion",  std::set<std::string>(), &test_occlusion);
+	runner.add("toys/cached",  std::set<std::string>(), &test_cached);
+	runner.add("toys/anim",  std::set<std::string>(), &test_anim);
+	runner.add("toys/framestats",  std::set<std::string>(), &test_framestats);
+	runner.add("toys/term",  std::set<std::string>(), &test_term);
+	runner.add("toys/mpsc",  std::set<std::string>(), &test_mpsc);
 	runner.add("toys/sdltext", std::set<std::string>(), &test_sdltext);
+	runner.add("toys/sdlcached", std::set<std::string>(), &test_sdlcached);
+	runner.add("toys/sdlfonts", std::set<std::string>(), &test_sdlfonts);
+	runner.add("toys/sdltasks", std::set<std::string>(), &test_sdltasks);
+	runner.add("toys/sdlwindows", std::set<std::string>(), &test_sdlwindows);
 	runner.add("toys/sdlbox", std::set<std::string>(), &test_sdlbox);
 }
 